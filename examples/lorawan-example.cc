@@ -21,6 +21,8 @@
 #include "ns3/mobility-helper.h"
 #include "ns3/position-allocator.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/periodic-sender-helper.h"
 #include "ns3/command-line.h"
@@ -58,6 +60,38 @@ unsigned long long bbox = 100000;
 
 int algorithm = 0;
 std::string edPositionFilename = "";
+std::string coverCacheDirectory = "";
+std::string layoutFilename = "";
+
+/*
+ * Set the data rate of each end device from the gateway the cover assigned
+ * it to, as LorawanMacHelper::SetSpreadingFactorsUp does from the best of
+ * all the gateways: the fastest rate whose sensitivity the received power
+ * beats, from DR5 (SF7) down to DR0 (SF12).
+ */
+void
+SetSpreadingFactorsFromCover (NodeContainer endDevices, NodeContainer gateways,
+                              Ptr<LoraChannel> channel, const UdcAssignment &assignment)
+{
+  for (uint32_t i = 0; i < endDevices.GetN (); ++i)
+    {
+      Ptr<Node> device = endDevices.Get (i);
+      Ptr<Node> gateway = gateways.Get (assignment.GetGateway (i));
+      const double rxPower = channel->GetRxPower (14, device->GetObject<MobilityModel> (),
+                                                  gateway->GetObject<MobilityModel> ());
+      uint8_t dataRate = 0;
+      for (int sf = 0; sf < 6; ++sf)
+        {
+          if (rxPower > EndDeviceLoraPhy::sensitivity[sf])
+            {
+              dataRate = 5 - sf;
+              break;
+            }
+        }
+      Ptr<LoraNetDevice> loraNetDevice = device->GetDevice (0)->GetObject<LoraNetDevice> ();
+      loraNetDevice->GetMac ()->GetObject<ClassAEndDeviceLorawanMac> ()->SetDataRate (dataRate);
+    }
+}
 
 
 int
@@ -69,8 +103,10 @@ main (int argc, char *argv[])
   //
 
   CommandLine cmd;
-  cmd.AddValue ("algorithm", "The Unit Disk Cover approximation algorithm to use", algorithm);
+  cmd.AddValue ("algorithm", "The Unit Disk Cover approximation algorithm to use (0 FastCover, 1 sweep, 2 strips, 3 hexagonal FastCover, 4 best of all)", algorithm);
   cmd.AddValue ("file", "The file representing end devices locations.", edPositionFilename);
+  cmd.AddValue ("cache", "Directory of gateway layouts reused across runs, empty for none", coverCacheDirectory);
+  cmd.AddValue ("layout", "SVG file to draw the devices and gateway coverage to, empty for none", layoutFilename);
   cmd.AddValue ("n", "Number of end devices to include in the simulation", nDevices);
   cmd.AddValue ("box", "The variance of the randomly generated device positions", bbox);
   cmd.AddValue ("radius", "The radius of the presumed coverage area of each GW", radius);
@@ -242,25 +278,15 @@ main (int argc, char *argv[])
   Ptr<UDCPositionAllocator> gwPosition = CreateObject<UDCPositionAllocator> ();
   gwPosition->SetSites (endDevices);
   gwPosition->SetAlgorithm (algorithm);
+  gwPosition->SetAttribute ("CacheDirectory", StringValue (coverCacheDirectory));
+  // Without a cache, keep the gateway the cover gives each end device
+  gwPosition->SetAttribute ("RecordAssignment", BooleanValue (coverCacheDirectory.empty ()));
   gwPosition->CoverSites (radius); // Coverage area assumed to be 10 km
   std::cout<<"Added "<< gwPosition->GetSitesN() << " positions to cover."<<std::endl;
   std::cout<<"Added "<< gwPosition->GetSize() << " gateways from UDC."<<std::endl;
 
-  // gwMobility
-  MobilityHelper gwMobility;
-  gwMobility.SetPositionAllocator (gwPosition);
-  gwMobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
-
-
-  // Create the gateway nodes
-  NodeContainer gateways;
-  gateways.Create (gwPosition->GetSize());
-
-//  Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator> ();
-//  // Make it so that nodes are at a certain height > 0
-//  allocator->Add (Vector (0.0, 0.0, 15.0));
-  gwMobility.SetPositionAllocator (gwPosition);
-  gwMobility.Install (gateways);
+  // Create the gateway nodes, each at its position
+  NodeContainer gateways = gwPosition->CreateGateways ();
 
   // Create a netdevice for each gateway
   phyHelper.SetDeviceType (LoraPhyHelper::GW);
@@ -324,7 +350,15 @@ main (int argc, char *argv[])
    *  Set up the end device's spreading factor  *
    **********************************************/
 
-  macHelper.SetSpreadingFactorsUp (endDevices, gateways, channel);
+  // From the gateway of each end device if the cover kept it, else from the best of all
+  if (gwPosition->GetAssignment ().IsEmpty ())
+    {
+      macHelper.SetSpreadingFactorsUp (endDevices, gateways, channel);
+    }
+  else
+    {
+      SetSpreadingFactorsFromCover (endDevices, gateways, channel, gwPosition->GetAssignment ());
+    }
 
   NS_LOG_DEBUG ("Completed configuration");
 
@@ -364,7 +398,10 @@ main (int argc, char *argv[])
   ////////////////
 
 
-  gwPosition->Print ();
+  if (!layoutFilename.empty ())
+    {
+      gwPosition->ExportLayout (layoutFilename);
+    }
 
   Simulator::Stop (appStopTime + Hours (1));
 
@@ -381,6 +418,11 @@ main (int argc, char *argv[])
   LoraPacketTracker &tracker = helper.GetPacketTracker ();
   std::cout << tracker.CountMacPacketsGlobally (Seconds (0), appStopTime + Hours (1)) << std::endl;
 
+  if (!layoutFilename.empty () && gwPosition->WaitForExport ())
+    {
+      NS_LOG_INFO ("Layout drawn to " << layoutFilename);
+    }
+
 
   return 0;
 }
@@ -18,70 +18,68 @@
  * Author: Matthew Graham <mattgrahamatc@gmail.com>
  */
 #include "udc-allocator.h"
-
+#include "udc-cell-table.h"
+#include "udc-components.h"
+#include "udc-cover-cache.h"
+#include "udc-cover-core.h"
+#include "udc-disk-grid.h"
+#include "udc-external-sort.h"
+#include "udc-layout.h"
+#include "udc-radix-sort.h"
+#include "udc-simd.h"
+#include "udc-site-store.h"
+#include "udc-sweep-buckets.h"
+
+#include "ns3/boolean.h"
 #include "ns3/double.h"
 #include "ns3/string.h"
 #include "ns3/pointer.h"
 #include "ns3/uinteger.h"
 #include "ns3/enum.h"
+#include "ns3/nstime.h"
 #include "ns3/log.h"
+#include "ns3/trace-source-accessor.h"
 #include "ns3/vector.h"
 #include "ns3/mobility-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/assert.h"
 
 #include <algorithm>
+#include <atomic>
+#include <climits>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <queue>
 #include <set>
-#include <unordered_set>
+#include <string>
+#include <unordered_map>
 #include <utility>
 
-#include <CGAL/squared_distance_3.h>
-
 namespace ns3 {
 
-NS_OBJECT_ENSURE_REGISTERED (UDCPositionAllocator);
+NS_LOG_COMPONENT_DEFINE ("UDCPositionAllocator");
 
-struct pair_hash {
-    inline size_t operator()(const std::pair<int,int> &v) const {
-        return v.first*31+v.second;
-    }
-};
+NS_OBJECT_ENSURE_REGISTERED (UDCPositionAllocator);
 
-struct sortByX {
-	template<typename Point>
-	bool operator()(const Point &p1, const Point &p2) {
-		return p1.x() < p2.x();
-	}
-};
 inline bool
 isEven(int n) {
     return (n % 2 == 0);
 }
 
-inline bool
-isPresent(const std::unordered_set<std::pair<int,int>, pair_hash> &table, const int vertical, const int horizontal) {
-    return table.find(std::make_pair(vertical,horizontal)) != table.end();
-}
+// The largest part of the radius the storage of the sites may err by
+static const double MAX_SITE_ERROR = 1e-3;
 
 bool
 operator== (const Vector& l, const Vector& r) {
 	return l.x == r.x && l.y == r.y && l.z == r.z;
 }
 
-inline UDCPositionAllocator::Point_3
-CreatePointFromVector (const Vector& v) {
-	return UDCPositionAllocator::Point_3(v.x,v.y,v.z);
-}
-
-inline double
-UDCPositionAllocator::SquaredDistance (const Vector& l, const Vector& r) {
-	return CGAL::squared_distance(
-			CreatePointFromVector (l),
-			CreatePointFromVector (r)
-	);
-}
-
 TypeId
 UDCPositionAllocator::GetTypeId (void)
 {
@@ -89,10 +87,109 @@ UDCPositionAllocator::GetTypeId (void)
     .SetParent<PositionAllocator> ()
     .SetGroupName ("Mobility")
     .AddConstructor<UDCPositionAllocator> ()
+    .AddAttribute ("Threads",
+                   "Number of worker threads for the parallel algorithms, 0 for one per hardware thread.  "
+                   "PORTFOLIO runs each of its algorithms on a thread of its own regardless.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&UDCPositionAllocator::m_threads),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MinBandSites",
+                   "Fewest sites in each band of a parallel FAST_COVER.  With fewer than twice as many "
+                   "sites, FAST_COVER runs on one thread, since the tiling costs more than it saves.",
+                   UintegerValue (uint64_t (1) << 20),
+                   MakeUintegerAccessor (&UDCPositionAllocator::m_minBandSites),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("Components",
+                   "Cover separately, in parallel, the groups of sites that are more "
+                   "than two radii from each other.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&UDCPositionAllocator::m_components),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PruneRedundant",
+                   "Remove the disks of every cover whose sites other disks also cover.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&UDCPositionAllocator::m_prune),
+                   MakeBooleanChecker ())
+    .AddAttribute ("VerifyCover",
+                   "Check every cover against the sites, logging a warning for any "
+                   "site left uncovered.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&UDCPositionAllocator::m_verify),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SitePrecision",
+                   "How the sites are stored.  Float and Quantized halve the memory "
+                   "and shrink the disks by the rounding error they introduce, which "
+                   "grows with the extent of the sites; where it would exceed a "
+                   "thousandth of the radius, a finer precision is used instead.  "
+                   "The sites are held as given until the first cover.",
+                   EnumValue (UdcSiteStore::DOUBLE),
+                   MakeEnumAccessor (&UDCPositionAllocator::m_sitePrecision),
+                   MakeEnumChecker (UdcSiteStore::DOUBLE, "Double",
+                                    UdcSiteStore::FLOAT, "Float",
+                                    UdcSiteStore::QUANTIZED, "Quantized"))
+    .AddAttribute ("MemoryBudget",
+                   "Bytes CoverSiteFile may hold sites in while sorting them, "
+                   "and disks in while sweeping them.",
+                   UintegerValue (uint64_t (1) << 30),
+                   MakeUintegerAccessor (&UDCPositionAllocator::m_memoryBudget),
+                   MakeUintegerChecker<uint64_t> (uint64_t (1) << 20))
+    .AddAttribute ("SweepEngine",
+                   "Active-set structure used by the SWEEP algorithm.",
+                   EnumValue (SWEEP_TREE),
+                   MakeEnumAccessor (&UDCPositionAllocator::m_sweepEngine),
+                   MakeEnumChecker (SWEEP_TREE, "Tree",
+                                    SWEEP_BUCKETS, "Buckets"))
+    .AddAttribute ("Geometry",
+                   "Arithmetic the algorithms take distances in, each a variant compiled "
+                   "of its own.  Double and Cgal place the same disks, but for "
+                   "rounding in the strips of STRIPS; Float may place a few more.",
+                   EnumValue (GEOMETRY_DOUBLE),
+                   MakeEnumAccessor (&UDCPositionAllocator::m_geometry),
+                   MakeEnumChecker (GEOMETRY_DOUBLE, "Double",
+                                    GEOMETRY_FLOAT, "Float",
+                                    GEOMETRY_CGAL, "Cgal"))
+    .AddAttribute ("CacheDirectory",
+                   "Directory of covers kept across runs, looked up by the sites and "
+                   "settings before covering them.  Empty to always compute the cover.",
+                   StringValue (""),
+                   MakeStringAccessor (&UDCPositionAllocator::m_cacheDirectory),
+                   MakeStringChecker ())
+    .AddAttribute ("RecordAssignment",
+                   "Keep the gateway each site is assigned to while it is covered, "
+                   "see GetAssignment.  Covers are then not cached.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&UDCPositionAllocator::m_recordAssignment),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PortfolioDeadline",
+                   "Wall-clock time after which the PORTFOLIO algorithm stops the "
+                   "algorithms still running, zero for no limit.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&UDCPositionAllocator::m_portfolioDeadline),
+                   MakeTimeChecker ())
+    .AddAttribute ("LayoutPointBudget",
+                   "Most sites, and most disks, ExportLayout draws one by one; past it "
+                   "they are drawn as about as many tiles shaded by density.",
+                   UintegerValue (100000),
+                   MakeUintegerAccessor (&UDCPositionAllocator::m_layoutPointBudget),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddTraceSource ("CoverStats",
+                     "The times of the phases of a cover and counts of the work "
+                     "done, as CoverSites finishes.",
+                     MakeTraceSourceAccessor (&UDCPositionAllocator::m_coverStatsTrace),
+                     "ns3::UDCPositionAllocator::CoverStatsCallback")
   ;
   return tid;
 }
 
+UDCPositionAllocator::UDCPositionAllocator ()
+{
+}
+
+UDCPositionAllocator::~UDCPositionAllocator ()
+{
+  WaitForExport ();
+}
+
 void
 UDCPositionAllocator::SetAlgorithm (int method)
 {
@@ -102,372 +199,1127 @@ UDCPositionAllocator::SetAlgorithm (int method)
 void
 UDCPositionAllocator::SetSites (NodeContainer c)
 {
-	NodeContainer::Iterator i = c.Begin ();
-	Vector firstPosition = (*i)->GetObject<MobilityModel> ()->GetPosition ();
+	std::vector<double> x, y;
+	x.reserve (c.GetN());
+	y.reserve (c.GetN());
+
+	for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+	{
+		Vector position = (*i)->GetObject<MobilityModel> ()->GetPosition ();
+		x.push_back (position.x);
+		y.push_back (position.y);
+	}
+	m_sites.Assign (std::move (x), std::move (y));
+	SitesChanged ();
+}
+
+void
+UDCPositionAllocator::SetSites (const double *x, const double *y, size_t n)
+{
+  m_sites.Borrow (x, y, n);
+  SitesChanged ();
+}
+
+bool
+UDCPositionAllocator::SetSitesFromFile (const std::string &filename)
+{
+  if (!m_sites.MapFile (filename))
+    {
+      NS_LOG_ERROR ("Cannot map site file " << filename);
+      return false;
+    }
+  SitesChanged ();
+  return true;
+}
+
+void
+UDCPositionAllocator::SitesChanged (void)
+{
+  m_sortedSites.Clear ();
+  m_sortOrder.reset ();
+  m_assignment.Clear ();
+  m_incremental.reset ();
 
-	double MinX = firstPosition.x,
-		   MaxX = firstPosition.x,
-		   MinY = firstPosition.y,
-		   MaxY = firstPosition.y,
-		   MinZ = firstPosition.z,
-		   MaxZ = firstPosition.z;
+  const size_t n = m_sites.GetN ();
+  if (n == 0)
+    {
+      m_bounds = {Vector (), Vector ()};
+      return;
+    }
 
+  // Bounds of each chunk of sites, reduced serially
+  UdcThreadPool &pool = GetThreadPool ();
+  const size_t nChunks = std::min<size_t> (pool.GetN (), (n + 65535) / 65536);
+  std::vector<std::vector<Vector>> chunkBounds (nChunks);
+  pool.ParallelFor (nChunks, [&] (size_t c, unsigned) {
+    const size_t begin = n * c / nChunks, end = n * (c + 1) / nChunks;
+    Vector lo (m_sites.X (begin), m_sites.Y (begin), 0), hi (lo);
+    for (size_t i = begin + 1; i < end; ++i)
+      {
+        lo.x = std::min (lo.x, m_sites.X (i));
+        lo.y = std::min (lo.y, m_sites.Y (i));
+        hi.x = std::max (hi.x, m_sites.X (i));
+        hi.y = std::max (hi.y, m_sites.Y (i));
+      }
+    chunkBounds[c] = {lo, hi};
+  });
+
+  m_bounds = chunkBounds[0];
+  for (const auto &bounds : chunkBounds)
+    {
+      m_bounds[0].x = std::min (m_bounds[0].x, bounds[0].x);
+      m_bounds[0].y = std::min (m_bounds[0].y, bounds[0].y);
+      m_bounds[1].x = std::max (m_bounds[1].x, bounds[1].x);
+      m_bounds[1].y = std::max (m_bounds[1].y, bounds[1].y);
+    }
 
-	m_sites.reserve (c.GetN());
-	using std::min;
-	using std::max;
-	using std::cout;
+  CompactSites (m_radius);
+}
 
+void
+UDCPositionAllocator::CompactSites (double radius)
+{
+  // No coarser than keeps the error a small part of the radius, which is
+  // not known before the first cover
+  UdcSiteStore::Precision precision = radius > 0 ? m_sitePrecision : UdcSiteStore::DOUBLE;
+  while (precision != UdcSiteStore::DOUBLE
+         && UdcSiteStore::GetCompactError (precision, m_bounds[0].x, m_bounds[0].y, m_bounds[1].x, m_bounds[1].y)
+              > MAX_SITE_ERROR * radius)
+    {
+      precision = UdcSiteStore::Precision (precision - 1);
+    }
+  if (radius > 0 && precision != m_sitePrecision)
+    {
+      NS_LOG_WARN ("SitePrecision " << m_sitePrecision << " errs by more than " << MAX_SITE_ERROR
+                   << " of a radius of " << radius << " over these sites; storing them at precision " << precision);
+    }
+  // A store already coarser stays so, as the sites it was made from are gone
+  if (!m_sites.HasTail () && (m_sites.GetPrecision () == precision || precision == UdcSiteStore::DOUBLE))
+    {
+      return;
+    }
 
-	for ( ; i != c.End (); ++i)
-	{
-		Ptr<MobilityModel> edMobility = (*i)->GetObject<MobilityModel> ();
-		Vector position = edMobility->GetPosition ();
-		m_sites.push_back(position);
-
-		MinX = min (MinX, position.x);
-		MaxX = max (MaxX, position.x);
-		MinY = min (MinY, position.y);
-		MaxY = max (MaxY, position.y);
-		MinZ = min (MinZ, position.z);
-		MaxZ = max (MaxZ, position.z);
-		//std::cout<<position<<"\n";
-	}
-	m_bounds = {
-			{ MinX, MinY, MinZ },
-			{ MaxX, MaxY, MaxZ }
-	};
+  const double before = m_sites.GetMaxError ();
+  m_sites.Compact (precision, m_bounds[0].x, m_bounds[0].y, m_bounds[1].x, m_bounds[1].y);
+  m_sortedSites.Clear ();
+  m_sortOrder.reset ();
+
+  // Keep the stored sites, rounded either way, inside the bounds
+  const double error = m_sites.GetMaxError () - before;
+  m_bounds[0].x -= error;
+  m_bounds[0].y -= error;
+  m_bounds[1].x += error;
+  m_bounds[1].y += error;
 }
 
 void
 UDCPositionAllocator::CoverSites ( double radius )
 {
   m_radius = radius;
-  switch(m_method) {
-  case Algorithm::SWEEP:
-	  BLMS (radius);
-	  break;
-  case Algorithm::STRIPS:
-	  LL (radius);
-	  break;
-  case Algorithm::FAST_COVER:
-  default:
-	  FastCover (radius);
+  m_incremental.reset ();
+  m_positions.clear ();
+  m_next = 0;
+  m_gatewayIndexed = false;
+  m_assignment.Clear ();
+  m_cancelled = false;
+  m_stats.Clear ();
+
+  // Cover the sites as stored, shrinking the disks by the storage error
+  // so that the full-size disks cover the sites as given
+  CompactSites (m_radius);
+  radius = GetEffectiveRadius ();
+  NS_ABORT_MSG_IF (radius <= 0, "SitePrecision is too coarse for a radius of " << m_radius);
+  if (m_sites.GetMaxError () > MAX_SITE_ERROR * m_radius)
+    {
+      NS_LOG_WARN ("Site storage error " << m_sites.GetMaxError () << " is large for a radius of " << m_radius);
+    }
+
+  // A deadline makes a PORTFOLIO cover depend on the machine, so it is not
+  // kept, and the cache holds no assignments
+  const bool cached = !m_cacheDirectory.empty () && !m_recordAssignment
+    && !(m_method == PORTFOLIO && m_portfolioDeadline.IsStrictlyPositive ());
+  UdcCoverCache::Key key;
+  std::vector<Vector> positions;
+  bool loaded = false;
+  if (cached)
+    {
+      UdcPhaseTimer timer (&m_stats, UdcCoverStats::CACHE);
+      key = UdcCoverCache::MakeKey (m_sites, GetCacheParameters (), GetThreadPool ());
+      loaded = UdcCoverCache (m_cacheDirectory).Load (key, positions);
+    }
+  if (loaded)
+    {
+      UdcPhaseTimer timer (&m_stats, UdcCoverStats::PLACE);
+      NS_LOG_INFO ("Read cover " << key.ToString () << " of " << positions.size () << " disks from "
+                   << m_cacheDirectory);
+      for (const Vector &v : positions)
+        {
+          Add (v);
+        }
+    }
+  else
+    {
+      if (m_recordAssignment)
+        {
+          m_assignment.Reset (m_sites.GetN ());
+        }
+      if (m_components)
+        {
+          ComponentCover (radius);
+        }
+      else
+        {
+          RunAlgorithm (radius);
+        }
+      if (m_recordAssignment)
+        {
+          UdcPhaseTimer timer (&m_stats, UdcCoverStats::ASSIGN);
+          m_assignment.Build (m_positions.size ());
+        }
+
+      if (m_prune)
+        {
+          UdcPhaseTimer timer (&m_stats, UdcCoverStats::PRUNE);
+          const uint32_t removed = PruneRedundant ();
+          NS_LOG_INFO ("Pruned " << removed << " redundant disks, leaving " << m_positions.size ());
+        }
+
+      UdcPhaseTimer timer (&m_stats, UdcCoverStats::CACHE);
+      if (cached && !UdcCoverCache (m_cacheDirectory).Store (key, m_positions))
+        {
+          NS_LOG_WARN ("Cannot write cover " << key.ToString () << " to " << m_cacheDirectory);
+        }
+    }
+
+  {
+    UdcPhaseTimer timer (&m_stats, UdcCoverStats::INDEX);
+    GetGatewayIndex ();
   }
-}
-void
-UDCPositionAllocator::FastCover (double radius) {
-	/*
-	 * Code and algorithm from
-	 *
-	 * Ghosh, A., Hicks, B., Shevchenko, R. (2017):
-	 * Unit Disk Cover for Massive Point Sets.
-	 * In: Kotsireas I., Pardalos P., Parsopoulos
-	 * K., Souravlias D., Tsokas A. (eds) Analysis
-	 * of Experimental Algorithms. SEA 2019.
-	 * Lecture Notes in Computer Science, vol
-	 * 11544. Springer, Cham.
-	 * https://doi.org/10.1007/978-3-030-34029-2_10.
-	 */
-	using std::cout;
-
-    std::unordered_set< std::pair<int,int>, pair_hash> hashTableForLatticeDiskCenters;
-    const double sqrt2 = std::sqrt(2);
-    const double gridWidth = sqrt2 * radius;
-    const double additiveFactor = gridWidth/2;
-  //  const double onePointFiveOverSqrt2 =  1.5/sqrt2;
-//    const double oneOverTwoSqrt2 = 1/(2*sqrt2);
-    const double gridWidthTimesOnePointFive = gridWidth * 1.5;
-    const double gridWidthTimesZeroPointFive = gridWidth * 0.5;
-
-    double verticalTimesGridWidth, horizontalTimesGridWidth;
-    int vertical, horizontal;
-
-    for( Vector p : m_sites ) {
-    	//std::cout<<p<<"\n";
-        vertical = floor(p.x/gridWidth);
-        horizontal = floor(p.y/gridWidth);
-        verticalTimesGridWidth  = vertical * gridWidth;
-        horizontalTimesGridWidth  = horizontal * gridWidth;
-
-        if( isPresent(hashTableForLatticeDiskCenters,vertical,horizontal))
-           continue;
-
-        if( p.x >= verticalTimesGridWidth + gridWidthTimesOnePointFive
-         && isPresent( hashTableForLatticeDiskCenters, vertical+1, horizontal )
-         && !(SquaredDistance( p, Vector(gridWidth*(vertical+1)+additiveFactor, horizontalTimesGridWidth+additiveFactor, 0) )>1) )
-            continue;
-
-        if( p.x <= verticalTimesGridWidth - gridWidthTimesZeroPointFive
-         && isPresent( hashTableForLatticeDiskCenters, vertical-1, horizontal )
-         && !(SquaredDistance( p, Vector(gridWidth*(vertical-1)+additiveFactor, horizontalTimesGridWidth+additiveFactor, 0) )>1) )
-            continue;
-
-        if( p.y <= horizontalTimesGridWidth - gridWidthTimesZeroPointFive
-         && isPresent( hashTableForLatticeDiskCenters, vertical, horizontal-1 )
-         && !(SquaredDistance( p, Vector(verticalTimesGridWidth+additiveFactor, gridWidth*(horizontal-1)+additiveFactor, 0) )>1) )
-            continue;
-
-        if( p.y >= horizontalTimesGridWidth + gridWidthTimesOnePointFive
-         && isPresent( hashTableForLatticeDiskCenters, vertical, horizontal+1 )
-         && !(SquaredDistance( p, Vector(verticalTimesGridWidth+additiveFactor, gridWidth*(horizontal+1)+additiveFactor, 0) )>1) )
-            continue;
-
-        hashTableForLatticeDiskCenters.insert(std::pair<int,int>(vertical,horizontal));
-        Vector diskCenter (verticalTimesGridWidth+additiveFactor,
-        		           horizontalTimesGridWidth+additiveFactor,
-						   m_defaultHeight);
-        Add (diskCenter);
-        //cout<<diskCenter<<"\n";
+
+  if (m_verify)
+    {
+      UdcPhaseTimer timer (&m_stats, UdcCoverStats::VERIFY);
+      const CoverReport report = VerifyCover ();
+      if (report.uncovered > 0)
+        {
+          NS_LOG_WARN (report.uncovered << " of " << report.sites << " sites are uncovered, the farthest "
+                       << report.maxDistance << " from a disk center");
+        }
+      NS_LOG_INFO ("Verified " << report.sites << " sites, farthest " << report.maxDistance
+                   << " from a disk center");
     }
-}
-void
-UDCPositionAllocator::BLMS (double radius) {
-	/*
-	 * Algorithm from
-	 *
-	 * Biniaz, A., Liu, P., Maheshwari, A., Smid, M.:
-	 * Approximation algorithms for the unit disk cover
-	 * problem in 2D and 3D. Comput. Geom. 60, 8–18 (2017).
-	 *
-	 * Code adapted from
-	 *
-	 * Ghosh, A., Hicks, B., Shevchenko, R. (2017):
-	 * Unit Disk Cover for Massive Point Sets.
-	 * In: Kotsireas I., Pardalos P., Parsopoulos
-	 * K., Souravlias D., Tsokas A. (eds) Analysis
-	 * of Experimental Algorithms. SEA 2019.
-	 * Lecture Notes in Computer Science, vol
-	 * 11544. Springer, Cham.
-	 * https://doi.org/10.1007/978-3-030-34029-2_10.
-	 */
-
-	const double radius_squared = pow( radius, 2 );
-
-	typedef std::vector<Point_2> PointContainer;
-	typedef PointContainer::iterator PointIterator;
-
-	// Sort all points on x-coordinate
-	PointContainer P;
-	P.reserve(m_sites.size());
-	for( auto v : m_sites ) {
-		P.emplace_back( v.x, v.y );
-	}
-	std::sort( P.begin(), P.end(), [] ( const Point_2 &lhs, const Point_2 &rhs ) {
-		return lhs.x() < rhs.x();
-	});
-
-	// Create the BST
-	auto YItSorter = []( const PointIterator &lhs, const PointIterator &rhs ) {
-		return lhs->y() < rhs->y();
-	};
-    std::set<PointIterator,decltype(YItSorter)> BST(YItSorter); // the binary tree of y-sorted disks
-
-    // Predicate to tell if a point is covered by a disk
-	auto isCovered = [&]( const Point_2& p, const Point_2& q ) {
-	    return CGAL::squared_distance( p, q ) < radius_squared;
-	};
-
-	for( auto sit=P.begin(), dit=P.begin(); sit<P.end(); sit++ ) {
-		// Handle deletions
-		while( dit->x() + radius < sit->x() ) {
-			BST.erase(dit);
-			dit++;
-		}
-
-		// Handle site
-		auto p_plus = BST.lower_bound(sit),
-			 pos(p_plus); // one higher than the site (p+)
-
-		bool siteIsCovered = false;
-
-		while( pos != BST.end() && (*pos)->y() - sit->y() < radius && !siteIsCovered ) {
-			siteIsCovered = isCovered( *sit, **pos );
-			pos++;
-		}
-		pos = p_plus;
-
-		while( !siteIsCovered && pos != BST.begin() && sit->y() - (*--pos)->y() < radius ) {
-			siteIsCovered = isCovered( *sit, **pos );
-		}
-
-		if( !siteIsCovered ) {
-			// add disk centers to C
-	        Add (Vector( sit->x(), sit->y(), m_defaultHeight ));
-			BST.insert(sit); // insert the Point into the BST
-		}
 
-	}
+  m_stats.NoteBytes (m_sites.GetBytes () + m_positions.capacity () * sizeof (Vector));
+  m_coverStatsTrace (m_stats);
 }
+
 void
-UDCPositionAllocator::LL (double radius) {
-	/*
-	 * Algorithm from
-	 *
-	 * Liu, P., Lu, D.: A fast 25/6-approximation for the
-	 * minimum unit disk cover problem. arXiv preprint
-	 * arXiv:1406.3838 (2014).
-	 *
-	 * Code adapted from
-	 *
-	 * Ghosh, A., Hicks, B., Shevchenko, R. (2017):
-	 * Unit Disk Cover for Massive Point Sets.
-	 * In: Kotsireas I., Pardalos P., Parsopoulos
-	 * K., Souravlias D., Tsokas A. (eds) Analysis
-	 * of Experimental Algorithms. SEA 2019.
-	 * Lecture Notes in Computer Science, vol
-	 * 11544. Springer, Cham.
-	 * https://doi.org/10.1007/978-3-030-34029-2_10.
-	 */
-
-	using std::list;
-	using std::vector;
-
-	typedef std::vector<Point_2> PointContainer;
-	//typedef PointContainer::iterator PointIterator;
-
-	// Sort all points on x-coordinate
-	PointContainer P;
-	P.reserve(m_sites.size());
-	for( auto v : m_sites ) {
-		P.emplace_back( v.x, v.y );
-	}
+UDCPositionAllocator::RunAlgorithm (double radius)
+{
+  if (m_method == PORTFOLIO)
+    {
+      Portfolio ();
+      return;
+    }
+  NS_ASSERT_MSG (m_sites.GetN () <= UINT32_MAX, "Too many sites to cover");
 
-	const long double sqrt3TimesRadius = std::sqrt(3)*radius, sqrt3TimesRadiusOver2 = sqrt3TimesRadius/2;
-	unsigned answer = P.size()+1;
-	sort(P.begin(),P.end(),sortByX());
-	list<Point_2> C;
+  UdcCover cover (m_sites, m_bounds[0].x, m_bounds[0].y, m_bounds[1].x, m_bounds[1].y, GetThreadPool ());
+  if (m_method == SWEEP || m_method == STRIPS)
+    {
+      const UdcSiteStore &sorted = GetSortedSites ();
+      cover.SetSortedSites (sorted, m_sortOrder.get ());
+    }
+  cover.SetSweepEngine (UdcCover::SweepEngine (m_sweepEngine));
+  cover.SetMinBandSites (m_minBandSites);
+  cover.SetStop ([this] () { return Cancelled (); });
+  cover.SetStats (&m_stats);
+  if (m_recordAssignment)
+    {
+      cover.SetAssignment (&m_assignment);
+    }
 
+  // The core numbers the disks from the start of x and y, as m_positions does
+  NS_ASSERT (m_positions.empty ());
+  std::vector<double> x, y;
+  const UdcCover::Algorithm algorithm = UdcCover::Algorithm (m_method);
+  switch (m_geometry)
+    {
+    case GEOMETRY_FLOAT:
+      cover.Run<UdcFloatGeometry> (algorithm, radius, x, y);
+      break;
+    case GEOMETRY_CGAL:
+      cover.Run<UdcCgalGeometry> (algorithm, radius, x, y);
+      break;
+    case GEOMETRY_DOUBLE:
+    default:
+      cover.Run<UdcDoubleGeometry> (algorithm, radius, x, y);
+    }
+  UdcPhaseTimer timer (&m_stats, UdcCoverStats::PLACE);
+  for (size_t d = 0; d < x.size (); ++d)
+    {
+      Add (Vector (x[d], y[d], m_defaultHeight));
+    }
+}
 
-	for(unsigned i = 0; i < 6; i++) {
+void
+UDCPositionAllocator::ComponentCover (double radius)
+{
+  UdcThreadPool &pool = GetThreadPool ();
+  UdcComponents components;
+  std::vector<size_t> jobFirst;
+  {
+    UdcPhaseTimer timer (&m_stats, UdcCoverStats::COMPONENTS);
+    components.Build (m_sites, m_bounds[0].x, m_bounds[0].y, 2 * radius, pool);
+    jobFirst = PackComponents (components);
+  }
+  NS_LOG_DEBUG (components.GetN () << " components of sites");
 
-		unsigned current = 0;
-		long double rightOfCurrentStrip = P[0].x()  + ((i*sqrt3TimesRadius)/6);
-		list<Point_2> tempC;
+  const size_t jobs = jobFirst.size () - 1;
+  if (jobs <= 1)
+    {
+      RunAlgorithm (radius);
+      return;
+    }
 
-		while( current < P.size() ) {
+  // Every job is covered by an allocator of its own, on one thread, over
+  // a copy of its sites.  Objects are only created here, not by the workers.
+  struct Job
+  {
+    size_t sites = 0;
+    std::vector<double> x, y;
+    Ptr<UDCPositionAllocator> allocator;
+  };
+  std::vector<Job> job (jobs);
+  for (size_t j = 0; j < jobs; ++j)
+    {
+      for (size_t c = jobFirst[j]; c < jobFirst[j + 1]; ++c)
+        {
+          job[j].sites += components.GetSize (c);
+        }
+      job[j].allocator = CreateWorker ();
+      job[j].allocator->m_recordAssignment = m_recordAssignment;
+    }
 
-			if(P[current].x() > rightOfCurrentStrip) {
-				int jump = (P[current].x() - rightOfCurrentStrip) / sqrt3TimesRadius;
-				rightOfCurrentStrip += jump*sqrt3TimesRadius;
+  // The largest jobs first, so that the stealing evens out the rest
+  std::vector<size_t> bySize (jobs);
+  for (size_t j = 0; j < jobs; ++j)
+    {
+      bySize[j] = j;
+    }
+  std::stable_sort (bySize.begin (), bySize.end (), [&job] (size_t l, size_t r) {
+    return job[l].sites > job[r].sites;
+  });
+
+  pool.ParallelForStealing (jobs, [&] (size_t t, unsigned) {
+    Job &j = job[bySize[t]];
+    j.x.reserve (j.sites);
+    j.y.reserve (j.sites);
+    for (size_t c = jobFirst[bySize[t]]; c < jobFirst[bySize[t] + 1]; ++c)
+      {
+        const uint32_t *sites = components.GetSites (c);
+        for (size_t k = 0; k < components.GetSize (c); ++k)
+          {
+            j.x.push_back (m_sites.X (sites[k]));
+            j.y.push_back (m_sites.Y (sites[k]));
+          }
+      }
+    j.allocator->SetSites (j.x.data (), j.y.data (), j.sites);
+    j.allocator->CoverSites (radius);
+  });
+
+  for (size_t j = 0; j < jobs; ++j)
+    {
+      m_stats.Add (job[j].allocator->m_stats);
+      // The job numbered its sites in the order they were copied to it
+      if (m_recordAssignment)
+        {
+          const UdcAssignment &assignment = job[j].allocator->m_assignment;
+          uint32_t local = 0;
+          for (size_t c = jobFirst[j]; c < jobFirst[j + 1]; ++c)
+            {
+              const uint32_t *sites = components.GetSites (c);
+              for (size_t k = 0; k < components.GetSize (c); ++k)
+                {
+                  m_assignment.Assign (sites[k], m_positions.size () + assignment.GetGateway (local++));
+                }
+            }
+        }
+      UdcPhaseTimer timer (&m_stats, UdcCoverStats::PLACE);
+      for (const Vector &v : job[j].allocator->m_positions)
+        {
+          Add (v);
+        }
+    }
+}
 
-				if(jump > 0)
-					continue;
-			}
+std::vector<size_t>
+UDCPositionAllocator::PackComponents (const UdcComponents& components) const
+{
+  // The packing does not depend on the threads, nor does the cover
+  const size_t target = std::max<size_t> (4096, m_sites.GetN () / 256);
+  std::vector<size_t> jobFirst (1, 0);
+  size_t size = 0;
+  for (size_t c = 0; c < components.GetN (); ++c)
+    {
+      size += components.GetSize (c);
+      if (size >= target || c + 1 == components.GetN ())
+        {
+          jobFirst.push_back (c + 1);
+          size = 0;
+        }
+    }
+  return jobFirst;
+}
 
-			unsigned indexOfTheFirstPointInTheCurrentStrip = current;
+Ptr<UDCPositionAllocator>
+UDCPositionAllocator::CreateWorker (void) const
+{
+  Ptr<UDCPositionAllocator> worker = CreateObject<UDCPositionAllocator> ();
+  worker->m_method = m_method;
+  worker->m_sweepEngine = m_sweepEngine;
+  worker->m_geometry = m_geometry;
+  worker->m_defaultHeight = m_defaultHeight;
+  worker->m_portfolioDeadline = m_portfolioDeadline;
+  return worker;
+}
 
-			while(P[current].x() < rightOfCurrentStrip && current < P.size())
-				current++;
+std::vector<std::vector<Vector>>
+UDCPositionAllocator::CoverRadii (const std::vector<double>& radii)
+{
+  std::vector<std::vector<Vector>> covers (radii.size ());
+  if (radii.empty ())
+    {
+      return covers;
+    }
+  CompactSites (*std::min_element (radii.begin (), radii.end ()));
+  const double error = m_sites.GetMaxError ();
+  NS_ABORT_MSG_IF (*std::min_element (radii.begin (), radii.end ()) <= error,
+                   "SitePrecision is too coarse for a radius of " << *std::min_element (radii.begin (), radii.end ()));
+  const bool sorted = m_method == SWEEP || m_method == STRIPS || m_method == PORTFOLIO;
+  UdcThreadPool &pool = GetThreadPool ();
+
+  // The sites are covered whole, or as the components linked at the
+  // largest radius, which no smaller radius links any further.  Either
+  // way they are sorted once, for every radius.
+  std::vector<UDCPositionAllocator *> sources (1, this);
+  std::vector<Ptr<UDCPositionAllocator>> jobs;
+  if (m_components)
+    {
+      const double largest = *std::max_element (radii.begin (), radii.end ()) - error;
+      UdcComponents components;
+      components.Build (m_sites, m_bounds[0].x, m_bounds[0].y, 2 * largest, pool);
+      const std::vector<size_t> jobFirst = PackComponents (components);
+      if (jobFirst.size () > 2)
+        {
+          jobs.resize (jobFirst.size () - 1);
+          sources.clear ();
+          for (Ptr<UDCPositionAllocator> &job : jobs)
+            {
+              job = CreateWorker ();
+              sources.push_back (PeekPointer (job));
+            }
+          pool.ParallelForStealing (jobs.size (), [&] (size_t j, unsigned) {
+            std::vector<double> x, y;
+            for (size_t c = jobFirst[j]; c < jobFirst[j + 1]; ++c)
+              {
+                const uint32_t *sites = components.GetSites (c);
+                for (size_t k = 0; k < components.GetSize (c); ++k)
+                  {
+                    x.push_back (m_sites.X (sites[k]));
+                    y.push_back (m_sites.Y (sites[k]));
+                  }
+              }
+            jobs[j]->m_sites.Assign (std::move (x), std::move (y));
+            jobs[j]->SitesChanged ();
+            if (sorted)
+              {
+                jobs[j]->GetSortedSites ();
+              }
+          });
+        }
+    }
+  if (sorted && jobs.empty ())
+    {
+      GetSortedSites ();
+    }
 
+  // One allocator per radius and source, sharing the sites of the source
+  const size_t tasks = radii.size () * sources.size ();
+  std::vector<Ptr<UDCPositionAllocator>> workers (tasks);
+  for (size_t t = 0; t < tasks; ++t)
+    {
+      const UDCPositionAllocator &source = *sources[t % sources.size ()];
+      workers[t] = CreateWorker ();
+      workers[t]->m_prune = m_prune;
+      workers[t]->m_verify = m_verify;
+      workers[t]->m_sitePrecision = source.m_sites.GetPrecision ();
+      workers[t]->m_sites.Share (source.m_sites);
+      workers[t]->m_sortedSites.Share (source.m_sortedSites);
+      workers[t]->m_bounds = source.m_bounds;
+    }
 
-			vector<Segment_2> segments;
-			segments.reserve(current-indexOfTheFirstPointInTheCurrentStrip+1);
-			long double xOfRestrictionline = rightOfCurrentStrip - sqrt3TimesRadiusOver2;
+  // The largest sources first, so that the stealing evens out the rest
+  std::vector<size_t> bySize (tasks);
+  for (size_t t = 0; t < tasks; ++t)
+    {
+      bySize[t] = t;
+    }
+  std::stable_sort (bySize.begin (), bySize.end (), [&] (size_t l, size_t r) {
+    return sources[l % sources.size ()]->m_sites.GetN () > sources[r % sources.size ()]->m_sites.GetN ();
+  });
+
+  // The components hold decoded sites, which the given radius less the
+  // storage error covers
+  pool.ParallelForStealing (tasks, [&] (size_t t, unsigned) {
+    const size_t r = bySize[t] / sources.size ();
+    workers[bySize[t]]->CoverSites (jobs.empty () ? radii[r] : radii[r] - error);
+  });
+
+  for (size_t t = 0; t < tasks; ++t)
+    {
+      const std::vector<Vector> &positions = workers[t]->m_positions;
+      std::vector<Vector> &cover = covers[t / sources.size ()];
+      cover.insert (cover.end (), positions.begin (), positions.end ());
+    }
+  return covers;
+}
 
-			for(unsigned j = indexOfTheFirstPointInTheCurrentStrip; j < current; j++) {
-				long double distanceFromRestrictionLine = P[j].x()-xOfRestrictionline;
-				long double y = std::sqrt(pow(radius,2)-( distanceFromRestrictionLine*distanceFromRestrictionLine));
-				segments.emplace_back( Point_2(xOfRestrictionline,P[j].y()+y), Point_2(xOfRestrictionline,P[j].y()-y) );
-			}
+void
+UDCPositionAllocator::Portfolio (void)
+{
+  // Each on a thread of its own, so the order is only that of the runs reported
+  const Algorithm algorithms[] = {FAST_COVER, FAST_COVER_HEX, SWEEP, STRIPS};
+  const size_t runs = sizeof algorithms / sizeof algorithms[0];
+  GetSortedSites ();
+
+  const auto start = std::chrono::steady_clock::now ();
+  const bool limited = m_portfolioDeadline.IsStrictlyPositive ();
+  const auto stopAt = start + std::chrono::microseconds (m_portfolioDeadline.GetMicroSeconds ());
+  std::vector<Ptr<UDCPositionAllocator>> workers (runs);
+  for (size_t k = 0; k < runs; ++k)
+    {
+      workers[k] = CreateWorker ();
+      workers[k]->m_method = algorithms[k];
+      workers[k]->m_sitePrecision = m_sites.GetPrecision ();
+      workers[k]->m_sites.Share (m_sites);
+      workers[k]->m_sortedSites.Share (m_sortedSites);
+      workers[k]->m_sortOrder = m_sortOrder;
+      workers[k]->m_recordAssignment = m_recordAssignment;
+      workers[k]->m_bounds = m_bounds;
+      workers[k]->m_stoppable = limited && algorithms[k] != FAST_COVER;
+      workers[k]->m_stopAt = stopAt;
+    }
 
-			rightOfCurrentStrip += sqrt3TimesRadius;
+  // The workers subtract the storage error from the radius themselves.  The
+  // pool has a thread per run whatever the Threads attribute, or the
+  // deadline would stop whichever runs happened to start last.
+  m_portfolioRuns.assign (runs, PortfolioRun ());
+  UdcThreadPool pool (runs);
+  pool.ParallelFor (runs, [&] (size_t k, unsigned) {
+    const auto begin = std::chrono::steady_clock::now ();
+    workers[k]->CoverSites (m_radius);
+    PortfolioRun &run = m_portfolioRuns[k];
+    run.algorithm = algorithms[k];
+    run.seconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - begin).count ();
+    run.finished = !workers[k]->m_cancelled;
+    run.disks = run.finished ? workers[k]->GetSize () : 0;
+  });
+
+  // The fewest disks, the quickest algorithm on a tie.  FAST_COVER always finishes.
+  size_t best = 0;
+  for (size_t k = 1; k < runs; ++k)
+    {
+      if (m_portfolioRuns[k].finished && m_portfolioRuns[k].disks < m_portfolioRuns[best].disks)
+        {
+          best = k;
+        }
+    }
+  m_portfolioRuns[best].chosen = true;
+  m_stats.Add (workers[best]->m_stats);
+  UdcPhaseTimer timer (&m_stats, UdcCoverStats::PLACE);
+  for (const Vector &v : workers[best]->m_positions)
+    {
+      Add (v);
+    }
+  if (m_recordAssignment)
+    {
+      m_assignment = std::move (workers[best]->m_assignment);
+    }
 
-			if(segments.size() == 0)
-				continue;
+  for (const PortfolioRun &run : m_portfolioRuns)
+    {
+      NS_LOG_INFO ("Portfolio algorithm " << run.algorithm << (run.finished ? " finished" : " stopped")
+                   << " in " << run.seconds << " s with " << run.disks << " disks"
+                   << (run.chosen ? ", kept" : ""));
+    }
+}
 
-			sort(segments.begin(),segments.end(), [](const Segment_2& si, const Segment_2& sj) { return (si.target().y() > sj.target().y());});
+const std::vector<UDCPositionAllocator::PortfolioRun>&
+UDCPositionAllocator::GetPortfolioRuns (void) const
+{
+  return m_portfolioRuns;
+}
 
-			long double lowestY = segments[0].target().y();
+const UdcCoverStats&
+UDCPositionAllocator::GetStats (void) const
+{
+  return m_stats;
+}
 
-			for( unsigned k = 1; k < segments.size(); k++) {
-				if( segments[k].source().y() < lowestY ) {
-					tempC.emplace_back(xOfRestrictionline,lowestY);
-					lowestY = segments[k].target().y();
-				}
-			}
-			tempC.emplace_back(xOfRestrictionline,lowestY);
-		}
+const UdcAssignment&
+UDCPositionAllocator::GetAssignment (void) const
+{
+  return m_assignment;
+}
 
-	   //cout << tempC.size() << endl;
+const UdcGatewayIndex&
+UDCPositionAllocator::GetGatewayIndex (void) const
+{
+  // Checked again under the lock, so that only one of several callers builds it
+  if (!m_gatewayIndexed.load (std::memory_order_acquire))
+    {
+      std::lock_guard<std::mutex> lock (m_gatewayMutex);
+      if (!m_gatewayIndexed.load (std::memory_order_relaxed))
+        {
+          UdcDiskGrid grid;
+          BuildDiskGrid (grid);
+          m_gatewayIndex.Build (std::move (grid));
+          m_gatewayIndexed.store (true, std::memory_order_release);
+        }
+    }
+  return m_gatewayIndex;
+}
 
-		if( tempC.size() < answer) {
-			answer = tempC.size();
-			std::swap(C,tempC);
-		}
-	}
-	using std::cout;
-	cout<<"\n";
-	for( Point_2 p : C ) {
-        Add (Vector( p.x(), p.y(), m_defaultHeight ));
-        cout<<p<<"\n";
-	}
+void
+UDCPositionAllocator::FindNearestGateways (const double* x, const double* y, size_t n, size_t k,
+                                           uint32_t* gateways) const
+{
+  GetGatewayIndex ().Nearest (x, y, n, k, gateways, GetThreadPool ());
 }
 
 void
-UDCPositionAllocator::Print()
+UDCPositionAllocator::FindGatewaysWithin (const double* x, const double* y, size_t n, double range,
+                                          std::vector<uint64_t>& first, std::vector<uint32_t>& gateways) const
 {
-	using std::string;
-	using std::max;
-	using std::cout;
-	using std::endl;
+  GetGatewayIndex ().Within (x, y, n, range, first, gateways, GetThreadPool ());
+}
 
-	string FileName = "temp";
-	string TexFileName = FileName + ".tex";
-    std::FILE *fp = fopen (TexFileName.c_str() ,"w");
+bool
+UDCPositionAllocator::Cancelled (void)
+{
+  if (m_stoppable && !m_cancelled && std::chrono::steady_clock::now () >= m_stopAt)
+    {
+      m_cancelled = true;
+    }
+  return m_cancelled;
+}
 
-    fprintf (fp,"\\documentclass{standalone} \n\\usepackage{tikz} \n \n\n\\begin{document}\n");
-    fprintf (fp,"\n\n\n\\begin{tikzpicture}\n\n");
+UDCPositionAllocator::CoverReport
+UDCPositionAllocator::VerifyCover (void)
+{
+  CoverReport report;
+  report.sites = m_sites.GetN ();
+  report.coverage.assign (CoverReport::MAX_COVERAGE + 1, 0);
+  if (m_sites.IsEmpty ())
+    {
+      return report;
+    }
+
+  const double radius = GetEffectiveRadius ();
+  const double radiusSquared = radius * radius;
+  UdcDiskGrid disks;
+  BuildDiskGrid (disks);
+
+  // Each chunk fills its own report, merged in site order
+  UdcThreadPool &pool = GetThreadPool ();
+  const size_t n = m_sites.GetN ();
+  const size_t chunks = std::min<size_t> (pool.GetN () * 4, (n + 65535) / 65536);
+  std::vector<CoverReport> partial (chunks);
+  pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+    CoverReport &part = partial[c];
+    part.coverage.assign (CoverReport::MAX_COVERAGE + 1, 0);
+    for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i)
+      {
+        const double x = m_sites.X (i), y = m_sites.Y (i);
+        size_t covering = 0;
+        double nearest = std::numeric_limits<double>::infinity ();
+        disks.ForNear (x, y, [&] (size_t k) {
+          const double dx = x - disks.X (k), dy = y - disks.Y (k);
+          covering += WithinRadius (dx, dy, radiusSquared);
+          nearest = std::min (nearest, dx*dx + dy*dy);
+        });
+
+        if (covering == 0)
+          {
+            // Out from the cells ForNear saw, ring by ring, until no ring
+            // left can hold a disk closer than the nearest so far
+            int64_t ring, lastRing;
+            disks.GetRings (x, y, ring, lastRing);
+            for (ring = std::max<int64_t> (ring, 2); disks.GetN () > 0 && ring <= lastRing; ++ring)
+              {
+                const double reach = (ring - 1) * disks.GetCellWidth ();
+                if (nearest < reach * reach)
+                  {
+                    break;
+                  }
+                disks.ForRing (x, y, ring, [&] (size_t k) {
+                  const double dx = x - disks.X (k), dy = y - disks.Y (k);
+                  nearest = std::min (nearest, dx*dx + dy*dy);
+                });
+              }
+            ++part.uncovered;
+            if (part.uncoveredSites.size () < CoverReport::MAX_REPORTED)
+              {
+                part.uncoveredSites.push_back (i);
+              }
+          }
+        ++part.coverage[std::min (covering, CoverReport::MAX_COVERAGE)];
+        part.maxDistance = std::max (part.maxDistance, nearest);
+      }
+  });
+
+  for (const CoverReport &part : partial)
+    {
+      report.uncovered += part.uncovered;
+      report.maxDistance = std::max (report.maxDistance, part.maxDistance);
+      for (size_t k = 0; k <= CoverReport::MAX_COVERAGE; ++k)
+        {
+          report.coverage[k] += part.coverage[k];
+        }
+      for (uint32_t i : part.uncoveredSites)
+        {
+          if (report.uncoveredSites.size () < CoverReport::MAX_REPORTED)
+            {
+              report.uncoveredSites.push_back (i);
+            }
+        }
+    }
+  report.maxDistance = std::sqrt (report.maxDistance);
+  return report;
+}
 
-    // Print origin
-    //fprintf(fp,"\\draw [fill=white,stroke=green] (0,0) circle [radius=%f];\n",radiusOfPoints);
+uint32_t
+UDCPositionAllocator::PruneRedundant (void)
+{
+  const size_t n = m_sites.GetN (), m = m_positions.size ();
+  if (m == 0)
+    {
+      return 0;
+    }
+  NS_ASSERT_MSG (n <= UINT32_MAX && m <= UINT32_MAX, "Too many sites or disks to prune");
+
+  const double radius = GetEffectiveRadius ();
+  const double radiusSquared = radius * radius;
+  UdcDiskGrid disks;
+  BuildDiskGrid (disks);
+
+  UdcThreadPool &pool = GetThreadPool ();
+  const size_t chunks = std::min<size_t> (pool.GetN () * 4, (n + 65535) / 65536);
+  auto forCovering = [&] (size_t i, auto f) {
+    const double x = m_sites.X (i), y = m_sites.Y (i);
+    disks.ForNear (x, y, [&] (size_t k) {
+      if (WithinRadius (x - disks.X (k), y - disks.Y (k), radiusSquared))
+        {
+          f (disks.Id (k));
+        }
+    });
+  };
+
+  // The number of disks covering each site, and of sites in each disk
+  std::vector<uint32_t> covering (n, 0);
+  std::vector<std::atomic<uint32_t>> next (m + 1);
+  pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+    for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i)
+      {
+        forCovering (i, [&] (uint32_t d) {
+          ++covering[i];
+          next[d + 1].fetch_add (1, std::memory_order_relaxed);
+        });
+      }
+  });
+
+  // The sites of each disk, in CSR form
+  std::vector<uint32_t> firstSite (m + 1, 0);
+  for (size_t d = 0; d < m; ++d)
+    {
+      firstSite[d + 1] = firstSite[d] + next[d + 1].load (std::memory_order_relaxed);
+      next[d].store (firstSite[d], std::memory_order_relaxed);
+    }
+  std::vector<uint32_t> sites (firstSite[m]);
+  pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+    for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i)
+      {
+        forCovering (i, [&] (uint32_t d) {
+          sites[next[d].fetch_add (1, std::memory_order_relaxed)] = i;
+        });
+      }
+  });
+
+  // Greedily drop disks, those with the fewest sites first
+  std::vector<uint32_t> order (m);
+  for (uint32_t d = 0; d < m; ++d)
+    {
+      order[d] = d;
+    }
+  std::stable_sort (order.begin (), order.end (), [&] (uint32_t l, uint32_t r) {
+    return firstSite[l + 1] - firstSite[l] < firstSite[r + 1] - firstSite[r];
+  });
 
-    const double ResultantDimension = 20;
+  std::vector<bool> removed (m, false);
+  uint32_t nRemoved = 0;
+  for (uint32_t d : order)
+    {
+      bool redundant = true;
+      for (uint32_t k = firstSite[d]; k < firstSite[d + 1] && redundant; ++k)
+        {
+          redundant = covering[sites[k]] > 1;
+        }
+      if (redundant)
+        {
+          for (uint32_t k = firstSite[d]; k < firstSite[d + 1]; ++k)
+            {
+              --covering[sites[k]];
+            }
+          removed[d] = true;
+          ++nRemoved;
+        }
+    }
 
-    double ResizeFactor = ResultantDimension
-    			 	 	     / max (m_bounds[1].x-m_bounds[0].x,
-    						        max (m_bounds[1].y-m_bounds[0].y,
-    								     m_bounds[1].z-m_bounds[0].z));
+  // Move the sites of removed disks to a remaining disk covering them, and
+  // number the remaining disks as they are kept
+  std::vector<uint32_t> renumbered (m, UdcAssignment::NONE);
+  size_t kept = 0;
+  for (size_t d = 0; d < m; ++d)
+    {
+      if (!removed[d])
+        {
+          renumbered[d] = kept;
+          m_positions[kept++] = m_positions[d];
+        }
+    }
+  if (!m_assignment.IsEmpty ())
+    {
+      for (uint32_t d = 0; d < m; ++d)
+        {
+          if (removed[d])
+            {
+              continue;
+            }
+          for (uint32_t k = firstSite[d]; k < firstSite[d + 1]; ++k)
+            {
+              const uint32_t gateway = m_assignment.GetGateway (sites[k]);
+              if (gateway == UdcAssignment::NONE || removed[gateway])
+                {
+                  m_assignment.Assign (sites[k], d);
+                }
+            }
+        }
+      pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+        for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i)
+          {
+            const uint32_t gateway = m_assignment.GetGateway (i);
+            m_assignment.Assign (i, gateway == UdcAssignment::NONE ? gateway : renumbered[gateway]);
+          }
+      });
+      m_assignment.Build (kept);
+    }
+  m_positions.resize (kept);
+  m_next = 0;
+  m_gatewayIndexed = false;
+  m_incremental.reset ();
+  return nRemoved;
+}
 
-    const double RadiusOfPoints = 0.005*ResultantDimension;
+void
+UDCPositionAllocator::BuildDiskGrid (UdcDiskGrid& grid) const
+{
+  std::vector<double> x (m_positions.size ()), y (m_positions.size ());
+  for (size_t d = 0; d < m_positions.size (); ++d)
+    {
+      x[d] = m_positions[d].x;
+      y[d] = m_positions[d].y;
+    }
+  // Cells wide enough to reach the slack WithinRadius allows, over the
+  // bounds, which Add grows around every disk
+  grid.Build (x, y, GetEffectiveRadius () * (1 + 1e-9), m_bounds[0].x, m_bounds[0].y, m_bounds[1].x,
+              m_bounds[1].y);
+}
 
-    // Print coverage disks
-    for(Vector p : m_positions){
-        fprintf (fp, "\\draw [color=red!60, fill=red, fill opacity=0.05](%f,%f) circle [radius=%f];\n",
-        		 p.x*ResizeFactor, p.y*ResizeFactor, m_radius*ResizeFactor);
+bool
+UDCPositionAllocator::CoverSiteFile (const std::string &siteFile, double radius, const std::string &diskFile)
+{
+  UdcExternalSort sites (m_memoryBudget, diskFile);
+  if (!sites.Sort (siteFile, GetThreadPool ()))
+    {
+      NS_LOG_ERROR ("Cannot sort site file " << siteFile);
+      return false;
     }
-    // Print sites
-    for(Vector p : m_sites)
-        fprintf (fp, "\\draw [color=blue, fill=blue!63] (%f,%f) circle [radius=%f];\n",
-        		p.x*ResizeFactor, p.y*ResizeFactor, RadiusOfPoints);
 
-    // Draw scale
-    double scaleStartX = (m_bounds[1].x - 2*m_radius)*ResizeFactor,
-    	   scaleLabelX = scaleStartX + m_radius*ResizeFactor,
-    	   scaleEndX   = scaleLabelX + m_radius*ResizeFactor,
-		   scaleY	   = (m_bounds[1].y)*ResizeFactor + 0.5;
-    string scaleLabel = std::to_string(int(2*m_radius)) + "m";
-    fprintf (fp, "\\draw [|-|, ultra thick](%f,%f) -- (%f,%f) node[anchor=north]{%s} -- (%f,%f) ;\n",
-    		scaleStartX,scaleY,scaleLabelX,scaleY, scaleLabel.c_str(), scaleEndX,scaleY);
+  bool written = true;
+  auto write = [&] (UdcSiteFileWriter &disks, const std::string &name, std::function<void (double, double)> site) {
+    if (!disks.Open (name) || !sites.ForEach (site) || !disks.Close ())
+      {
+        NS_LOG_ERROR ("Cannot cover " << siteFile << " into " << name);
+        written = false;
+      }
+  };
+
+  UdcSiteFileWriter disks;
+  switch (m_method)
+    {
+    case Algorithm::SWEEP:
+      {
+        // The bucketed sweep, whose active disks drop behind the sweep line.
+        // The empty bands take at most a quarter of the budget, and the disks
+        // within one radius behind the line the rest.
+        const size_t bands = std::max<uint64_t> (1, m_memoryBudget / 4 / YBucketActiveSet::GetBucketBytes ());
+        YBucketActiveSet active (sites.GetMinY (), sites.GetMaxY (), radius, bands);
+        bool over = false;
+        write (disks, diskFile, [&] (double x, double y) {
+          if (!active.Covers (x, y))
+            {
+              disks.Push (x, y);
+              active.Insert (x, y);
+              if (!over && active.GetHeldBytes () > m_memoryBudget)
+                {
+                  NS_LOG_WARN ("The disks within one radius of x = " << x << " take more than the MemoryBudget of "
+                                                                     << m_memoryBudget << " bytes");
+                  over = true;
+                }
+            }
+        });
+        break;
+      }
+    case Algorithm::STRIPS:
+      {
+        // The six shifts in one pass, each into its own file, in double
+        // arithmetic whatever the Geometry attribute.  Each shift holds the
+        // chords of the whole strip it is filling, so a dense strip can take
+        // more than the budget.
+        std::vector<LLStripSweep<UdcDoubleGeometry>> shifts;
+        UdcSiteFileWriter shiftDisks[6];
+        for (unsigned i = 0; i < 6; ++i)
+          {
+            shifts.emplace_back (radius, i);
+            if (!shiftDisks[i].Open (diskFile + ".shift" + std::to_string (i)))
+              {
+                written = false;
+              }
+          }
+        auto emitTo = [&] (unsigned i) {
+          return [&shiftDisks, i] (double cx, double cy, const StripInterval *, const StripInterval *) {
+            shiftDisks[i].Push (cx, cy);
+          };
+        };
+        bool over = false;
+        if (written && sites.ForEach ([&] (double x, double y) {
+              size_t held = 0;
+              for (unsigned i = 0; i < 6; ++i)
+                {
+                  shifts[i].Push (x, y, 0, emitTo (i));
+                  held += shifts[i].GetHeldBytes ();
+                }
+              if (!over && held > m_memoryBudget)
+                {
+                  NS_LOG_WARN ("The strips around x = " << x << " take more than the MemoryBudget of "
+                                                        << m_memoryBudget << " bytes");
+                  over = true;
+                }
+            }))
+          {
+            for (unsigned i = 0; i < 6; ++i)
+              {
+                shifts[i].Finish (emitTo (i));
+              }
+          }
+        else
+          {
+            written = false;
+          }
+
+        unsigned best = 0;
+        for (unsigned i = 0; i < 6; ++i)
+          {
+            written = shiftDisks[i].Close () && written;
+            if (shiftDisks[i].GetN () < shiftDisks[best].GetN ())
+              {
+                best = i;
+              }
+          }
+        for (unsigned i = 0; i < 6; ++i)
+          {
+            const std::string name = diskFile + ".shift" + std::to_string (i);
+            if (i == best && written)
+              {
+                written = std::rename (name.c_str (), diskFile.c_str ()) == 0;
+              }
+            else
+              {
+                std::remove (name.c_str ());
+              }
+          }
+        if (!written)
+          {
+            NS_LOG_ERROR ("Cannot cover " << siteFile << " into " << diskFile);
+          }
+        break;
+      }
+    case Algorithm::FAST_COVER_HEX:
+      {
+        // Hexagons are claimed by sites at most one column width right of their
+        // center, and reach sites less than two columns right, so the cells of
+        // the column of the site and the two before it are all that is needed
+        const HexLattice lattice (radius);
+        LatticeCellTable columns[3]; // the current column first
+        int64_t column = 0;
+        bool started = false;
+        write (disks, diskFile, [&] (double x, double y) {
+          const int64_t c = std::floor (x / lattice.width);
+          const int64_t steps = started ? std::min<int64_t> (c - column, 3) : 3;
+          for (int64_t k = 0; k < steps; ++k)
+            {
+              columns[2] = std::move (columns[1]);
+              columns[1] = std::move (columns[0]);
+              columns[0] = LatticeCellTable ();
+            }
+          if (steps > 0)
+            {
+              int minQ = INT_MAX, maxQ = INT_MIN, minS = INT_MAX, maxS = INT_MIN;
+              for (const double cx : {c * lattice.width, (c + 1) * lattice.width})
+                {
+                  for (const double cy : {sites.GetMinY (), sites.GetMaxY ()})
+                    {
+                      int q, s;
+                      lattice.Cell (cx, cy, q, s);
+                      minQ = std::min (minQ, q - 1);
+                      maxQ = std::max (maxQ, q + 1);
+                      minS = std::min (minS, s - 1);
+                      maxS = std::max (maxS, s + 1);
+                    }
+                }
+              columns[0].Reserve (std::min (maxS - minS + 1, 1 << 16), minQ, maxQ, minS, maxS);
+            }
+          column = c;
+          started = true;
+          auto present = [&] (int q, int s) {
+            return columns[0].Contains (q, s) || columns[1].Contains (q, s) || columns[2].Contains (q, s);
+          };
+
+          int q, s;
+          lattice.Cell (x, y, q, s);
+          if (present (q, s))
+            {
+              return;
+            }
+          const double cx = x - lattice.CenterX (q, s), cy = y - lattice.CenterY (s);
+          if (!(cx * cx + cy * cy < lattice.innerSquared))
+            {
+              for (const auto &n : HEX_NEIGHBORS)
+                {
+                  const double dx = x - lattice.CenterX (q + n[0], s + n[1]), dy = y - lattice.CenterY (s + n[1]);
+                  if (dx * dx + dy * dy <= lattice.radiusSquared && present (q + n[0], s + n[1]))
+                    {
+                      return;
+                    }
+                }
+            }
+          columns[0].Insert (q, s);
+          disks.Push (lattice.CenterX (q, s), lattice.CenterY (s));
+        });
+        break;
+      }
+    case Algorithm::FAST_COVER:
+    default:
+      {
+        // The lattice columns arrive in order, so only the column of the site
+        // and the one before it can hold a disk that DecideCell looks up
+        const FastCoverLattice lattice (radius);
+        const int minRow = lattice.Cell (sites.GetMinY ()), maxRow = lattice.Cell (sites.GetMaxY ());
+        LatticeCellTable current, previous;
+        int column = 0;
+        bool started = false;
+        auto present = [&] (int vertical, int horizontal) {
+          if (vertical == column)
+            {
+              return int (current.Contains (vertical, horizontal));
+            }
+          if (vertical == column - 1)
+            {
+              return int (previous.Contains (vertical, horizontal));
+            }
+          return 0;
+        };
+        write (disks, diskFile, [&] (double x, double y) {
+          const int vertical = lattice.Cell (x), horizontal = lattice.Cell (y);
+          if (!started || vertical != column)
+            {
+              if (started && vertical == column + 1)
+                {
+                  previous = std::move (current);
+                }
+              else
+                {
+                  previous = LatticeCellTable ();
+                }
+              current = LatticeCellTable ();
+              current.Reserve (std::min (maxRow - minRow + 1, 1 << 16), vertical, vertical, minRow, maxRow);
+              column = vertical;
+              started = true;
+            }
+          if (DecideCell<UdcDoubleGeometry> (x, y, lattice, vertical, horizontal, present) == CELL_COVERED)
+            {
+              return;
+            }
+          current.Insert (vertical, horizontal);
+          disks.Push (vertical * lattice.gridWidth + lattice.additiveFactor,
+                      horizontal * lattice.gridWidth + lattice.additiveFactor);
+        });
+      }
+    }
+  return written;
+}
 
-    fprintf (fp, "\n\n\\end{tikzpicture}");
-    fprintf (fp, "\n\n\\end{document}");
-    fclose (fp);
+void
+UDCPositionAllocator::ExportLayout (const std::string& path)
+{
+  NS_ASSERT_MSG (m_bounds.size () == 2, "Set the sites before drawing them");
+  WaitForExport ();
+
+  // Take what is drawn now, bounded by the budget, and write it meanwhile
+  auto layout = std::make_shared<UdcLayout> (m_bounds[0].x, m_bounds[0].y, m_bounds[1].x, m_bounds[1].y,
+                                             m_layoutPointBudget);
+  layout->SetSites (m_sites, GetThreadPool ());
+  std::vector<double> x (m_positions.size ()), y (m_positions.size ());
+  for (size_t d = 0; d < m_positions.size (); ++d)
+    {
+      x[d] = m_positions[d].x;
+      y[d] = m_positions[d].y;
+    }
+  layout->SetDisks (x.data (), y.data (), x.size (), m_radius);
 
-    cout << "\nOutput PDF generation started..." << endl;
-    string command = "pdflatex " + TexFileName + " > /dev/null";
-    system (command.c_str());
-    cout << "PDF generation terminated..." << endl;
+  m_exportPath = path;
+  m_export = std::async (std::launch::async, [layout, path] () { return layout->WriteSvg (path); });
+}
 
-    command = "atril " + FileName + ".pdf &";
-    system (command.c_str());
+bool
+UDCPositionAllocator::WaitForExport (void)
+{
+  if (!m_export.valid ())
+    {
+      return true;
+    }
+  const bool written = m_export.get ();
+  if (!written)
+    {
+      NS_LOG_WARN ("Cannot write the layout to " << m_exportPath);
+    }
+  return written;
 }
 
 void
 UDCPositionAllocator::Add (Vector v)
 {
   m_positions.push_back (v);
-  m_current = m_positions.begin ();
 
   m_bounds[0].x = std::min (m_bounds[0].x, v.x-m_radius);
   m_bounds[0].y = std::min (m_bounds[0].y, v.y-m_radius);
@@ -477,17 +1329,329 @@ UDCPositionAllocator::Add (Vector v)
   m_bounds[1].z = std::max (m_bounds[1].z, v.z+m_radius);
 }
 
+/*
+ * Grids of cell width m_radius over the disks and the sites, so that the
+ * disks that may cover a site, and the sites a disk may cover, are all in
+ * the 3x3 cells around it.
+ */
+struct UDCPositionAllocator::IncrementalIndex
+{
+  typedef std::unordered_map<uint64_t, std::vector<uint32_t>> Grid;
+
+  explicit IncrementalIndex (double radius)
+    : cellWidth (radius),
+      radiusSquared (radius * radius)
+  {
+  }
+
+  int64_t Cell (double coordinate) const
+  {
+    return floor (coordinate / cellWidth);
+  }
+
+  uint64_t Key (const Vector &v) const
+  {
+    return LatticeCellTable::Pack (Cell (v.x), Cell (v.y));
+  }
+
+  // Call f(id) for every id in the 3x3 cells of grid around v
+  template <typename F>
+  void ForNear (const Grid &grid, const Vector &v, F f) const
+  {
+    const int64_t vertical = Cell (v.x), horizontal = Cell (v.y);
+    for (int64_t i = vertical - 1; i <= vertical + 1; ++i)
+      {
+        for (int64_t j = horizontal - 1; j <= horizontal + 1; ++j)
+          {
+            auto it = grid.find (LatticeCellTable::Pack (i, j));
+            if (it != grid.end ())
+              {
+                for (uint32_t id : it->second)
+                  {
+                    f (id);
+                  }
+              }
+          }
+      }
+  }
+
+  // Rename id from to id to in the cell with the given key; to == UINT32_MAX drops it
+  static void Rename (Grid &grid, uint64_t key, uint32_t from, uint32_t to)
+  {
+    std::vector<uint32_t> &ids = grid[key];
+    auto it = std::find (ids.begin (), ids.end (), from);
+    if (to == UINT32_MAX)
+      {
+        *it = ids.back ();
+        ids.pop_back ();
+        if (ids.empty ())
+          {
+            grid.erase (key);
+          }
+      }
+    else
+      {
+        *it = to;
+      }
+  }
+
+  double cellWidth, radiusSquared;
+  Grid disks;                 // cell -> indices into m_positions
+  Grid sites;                 // cell -> indices of sites
+  std::vector<uint32_t> load; // number of sites covered by each disk
+};
+
+UDCPositionAllocator::IncrementalIndex&
+UDCPositionAllocator::GetIncrementalIndex (void)
+{
+  NS_ASSERT_MSG (m_radius > 0, "Incremental updates need a cover; call CoverSites first");
+  if (!m_incremental)
+    {
+      m_incremental.reset (new IncrementalIndex (GetEffectiveRadius ()));
+      IncrementalIndex &index = *m_incremental;
+      for (uint32_t d = 0; d < m_positions.size (); ++d)
+        {
+          index.disks[index.Key (m_positions[d])].push_back (d);
+        }
+      index.load.assign (m_positions.size (), 0);
+      for (uint32_t i = 0; i < m_sites.GetN (); ++i)
+        {
+          const Vector p (m_sites.X (i), m_sites.Y (i), 0);
+          index.sites[index.Key (p)].push_back (i);
+          index.ForNear (index.disks, p, [&] (uint32_t d) {
+            if (WithinRadius (p.x - m_positions[d].x, p.y - m_positions[d].y, index.radiusSquared))
+              {
+                index.load[d]++;
+              }
+          });
+        }
+    }
+  return *m_incremental;
+}
+
+UDCPositionAllocator::CoverDelta
+UDCPositionAllocator::AddSite (const Vector& site)
+{
+  IncrementalIndex &index = GetIncrementalIndex ();
+  CoverDelta delta;
+
+  const uint32_t id = m_sites.GetN ();
+  m_sites.Push (site.x, site.y);
+  m_sortedSites.Clear ();
+  m_sortOrder.reset ();
+  m_assignment.Clear ();
+  index.sites[index.Key (site)].push_back (id);
+  m_bounds[0].x = std::min (m_bounds[0].x, site.x);
+  m_bounds[0].y = std::min (m_bounds[0].y, site.y);
+  m_bounds[1].x = std::max (m_bounds[1].x, site.x);
+  m_bounds[1].y = std::max (m_bounds[1].y, site.y);
+
+  bool covered = false;
+  index.ForNear (index.disks, site, [&] (uint32_t d) {
+    if (WithinRadius (site.x - m_positions[d].x, site.y - m_positions[d].y, index.radiusSquared))
+      {
+        index.load[d]++;
+        covered = true;
+      }
+  });
+  if (covered)
+    {
+      return delta;
+    }
+
+  Vector center (site.x, site.y, m_defaultHeight);
+  if (m_method == FAST_COVER)
+    {
+      const FastCoverLattice lattice (GetEffectiveRadius ());
+      center.x = lattice.Cell (site.x) * lattice.gridWidth + lattice.additiveFactor;
+      center.y = lattice.Cell (site.y) * lattice.gridWidth + lattice.additiveFactor;
+    }
+  else if (m_method == FAST_COVER_HEX)
+    {
+      const HexLattice lattice (GetEffectiveRadius ());
+      int q, s;
+      lattice.Cell (site.x, site.y, q, s);
+      center.x = lattice.CenterX (q, s);
+      center.y = lattice.CenterY (s);
+    }
+
+  const uint32_t disk = m_positions.size ();
+  Add (center);
+  m_next = 0;
+  m_gatewayIndexed = false;
+  index.disks[index.Key (center)].push_back (disk);
+  index.load.push_back (0);
+  index.ForNear (index.sites, center, [&] (uint32_t i) {
+    if (WithinRadius (m_sites.X (i) - center.x, m_sites.Y (i) - center.y, index.radiusSquared))
+      {
+        index.load[disk]++;
+      }
+  });
+  delta.added.push_back (center);
+  return delta;
+}
+
+UDCPositionAllocator::CoverDelta
+UDCPositionAllocator::RemoveSite (const Vector& site, bool dropEmpty)
+{
+  IncrementalIndex &index = GetIncrementalIndex ();
+  CoverDelta delta;
+
+  // A compacted store reads the site back up to its error away from the
+  // position given, so take the nearest site within that error
+  const double errorSquared = m_sites.GetMaxError () * m_sites.GetMaxError ();
+  uint32_t id = UINT32_MAX;
+  double nearest = 0;
+  index.ForNear (index.sites, site, [&] (uint32_t i) {
+    const double dx = m_sites.X (i) - site.x, dy = m_sites.Y (i) - site.y;
+    const double distance = dx * dx + dy * dy;
+    if (distance <= errorSquared && (id == UINT32_MAX || distance < nearest))
+      {
+        id = i;
+        nearest = distance;
+      }
+  });
+  if (id == UINT32_MAX)
+    {
+      NS_LOG_WARN ("RemoveSite: no site at " << site);
+      return delta;
+    }
+
+  // The disk loads and the grid were counted from the stored position
+  const Vector stored (m_sites.X (id), m_sites.Y (id), 0);
+  std::vector<uint32_t> empty;
+  index.ForNear (index.disks, stored, [&] (uint32_t d) {
+    if (WithinRadius (stored.x - m_positions[d].x, stored.y - m_positions[d].y, index.radiusSquared)
+        && --index.load[d] == 0 && dropEmpty)
+      {
+        empty.push_back (d);
+      }
+  });
+
+  // Move the last site into the freed slot
+  const uint32_t last = m_sites.GetN () - 1;
+  IncrementalIndex::Rename (index.sites, index.Key (stored), id, UINT32_MAX);
+  if (id != last)
+    {
+      const Vector moved (m_sites.X (last), m_sites.Y (last), 0);
+      IncrementalIndex::Rename (index.sites, index.Key (moved), last, id);
+    }
+  m_sites.SwapRemove (id);
+  m_sortedSites.Clear ();
+  m_sortOrder.reset ();
+  m_assignment.Clear ();
+
+  // Highest first, so that no disk still to remove gets moved
+  std::sort (empty.begin (), empty.end (), std::greater<uint32_t> ());
+  for (uint32_t d : empty)
+    {
+      delta.removed.push_back (m_positions[d]);
+      RemoveDisk (d);
+    }
+  return delta;
+}
+
+void
+UDCPositionAllocator::RemoveDisk (uint32_t disk)
+{
+  IncrementalIndex &index = *m_incremental;
+  const uint32_t last = m_positions.size () - 1;
+  IncrementalIndex::Rename (index.disks, index.Key (m_positions[disk]), disk, UINT32_MAX);
+  if (disk != last)
+    {
+      IncrementalIndex::Rename (index.disks, index.Key (m_positions[last]), last, disk);
+      m_positions[disk] = m_positions[last];
+      index.load[disk] = index.load[last];
+    }
+  m_positions.pop_back ();
+  index.load.pop_back ();
+  m_next = 0;
+  m_gatewayIndexed = false;
+}
+
 Vector
 UDCPositionAllocator::GetNext (void) const
 {
-  Vector v = *m_current;
-  m_current++;
-  if (m_current == m_positions.end ())
+  NS_ASSERT_MSG (!m_positions.empty (), "No positions to return");
+  // Each call claims an index of its own, so concurrent callers never collide
+  const uint64_t next = m_next.fetch_add (1, std::memory_order_relaxed);
+  return m_positions[next % m_positions.size ()];
+}
+
+const std::vector<Vector>&
+UDCPositionAllocator::GetPositions (void) const
+{
+  return m_positions;
+}
+
+NodeContainer
+UDCPositionAllocator::CreateGateways (void) const
+{
+  NodeContainer gateways;
+  gateways.Create (m_positions.size ());
+  for (uint32_t i = 0; i < gateways.GetN (); ++i)
     {
-      m_current = m_positions.begin ();
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (m_positions[i]);
+      gateways.Get (i)->AggregateObject (mobility);
     }
-  return v;
+  return gateways;
 }
+const UdcSiteStore&
+UDCPositionAllocator::GetSortedSites (void)
+{
+  if (m_sortedSites.GetN () != m_sites.GetN () || m_sortedSites.GetPrecision () != m_sites.GetPrecision ()
+      || (m_recordAssignment && !m_sortOrder))
+    {
+      NS_ASSERT_MSG (m_sites.GetN () <= UINT32_MAX, "Too many sites to sort");
+      UdcPhaseTimer timer (&m_stats, UdcCoverStats::SORT);
+      std::vector<uint32_t> order (m_sites.GetN ());
+      for (uint32_t i = 0; i < order.size (); ++i)
+        {
+          order[i] = i;
+        }
+      ParallelRadixSort (order, [this] (uint32_t i) { return m_sites.X (i); }, GetThreadPool ());
+      m_sortedSites.Gather (m_sites, order, GetThreadPool ());
+      m_sortOrder.reset ();
+      if (m_recordAssignment)
+        {
+          m_sortOrder = std::make_shared<const std::vector<uint32_t>> (std::move (order));
+        }
+    }
+  return m_sortedSites;
+}
+
+std::vector<uint64_t>
+UDCPositionAllocator::GetCacheParameters (void) const
+{
+  auto bits = [] (double d) {
+    uint64_t word;
+    std::memcpy (&word, &d, sizeof word);
+    return word;
+  };
+  // Bump the first parameter when a change to an algorithm changes its covers
+  return {2, uint64_t (m_method), uint64_t (m_sweepEngine), uint64_t (m_components), uint64_t (m_prune),
+          bits (m_radius), bits (m_defaultHeight), uint64_t (m_geometry)};
+}
+
+double
+UDCPositionAllocator::GetEffectiveRadius (void) const
+{
+  return m_radius - m_sites.GetMaxError ();
+}
+
+UdcThreadPool&
+UDCPositionAllocator::GetThreadPool (void) const
+{
+  unsigned threads = m_threads == 0 ? std::max (1u, std::thread::hardware_concurrency ()) : m_threads;
+  std::lock_guard<std::mutex> lock (m_poolMutex);
+  if (!m_pool || m_pool->GetN () != threads)
+    {
+      m_pool.reset (new UdcThreadPool (threads));
+    }
+  return *m_pool;
+}
+
 int64_t
 UDCPositionAllocator::AssignStreams (int64_t stream)
 {
@@ -503,7 +1667,7 @@ UDCPositionAllocator::GetSize (void) const
 uint32_t
 UDCPositionAllocator::GetSitesN (void) const
 {
-  return m_sites.size ();
+  return m_sites.GetN ();
 }
 
 
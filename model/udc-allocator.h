@@ -21,14 +21,30 @@
 #define UDC_ALLOCATOR_H
 
 #include "ns3/node-container.h"
+#include "ns3/nstime.h"
 #include "ns3/position-allocator.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/traced-callback.h"
 #include "ns3/vector.h"
 
-#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+#include "udc-assignment.h"
+#include "udc-cgal-geometry.h"
+#include "udc-cover-stats.h"
+#include "udc-gateway-index.h"
+#include "udc-site-store.h"
+#include "udc-thread-pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
 
 namespace ns3 {
 
+class UdcComponents;
+class UdcDiskGrid;
+
 //
 // I have copied the structure of this object from
 // the ListPositionAllocator and modified as needed.
@@ -47,36 +63,371 @@ namespace ns3 {
  * The first call to ListPositionAllocator::GetNext will return the
  * first disk placed by the algorithm, the second call, the second disk,
  * and so on.
+ *
+ * The algorithms themselves are in UdcCover, which does not depend on
+ * ns-3; this class adds the attributes, the cache, the components and
+ * PORTFOLIO around it.
  */
 class UDCPositionAllocator : public PositionAllocator
 {
 public:
    enum Algorithm {
-	   FAST_COVER = 0, SWEEP, STRIPS
+	   FAST_COVER = 0, //!< Ghosh et al, disks on a square lattice
+	   SWEEP,          //!< Biniaz et al, a plane sweep
+	   STRIPS,         //!< Liu-Lu, the best of six strip shifts
+	   FAST_COVER_HEX, //!< Ghosh et al, disks on a hexagonal lattice
+	   PORTFOLIO       //!< all of the above at once, keeping the fewest disks
+   };
+   /**
+    * Active-set structures available to the SWEEP algorithm
+    */
+   enum SweepEngine
+   {
+     SWEEP_TREE = 0, //!< std::set of active disks ordered by y
+     SWEEP_BUCKETS   //!< flat arrays of active disks in bands of y
+   };
+   /**
+    * Geometry policies the algorithms are compiled for, see udc-geometry.h
+    */
+   enum Geometry
+   {
+     GEOMETRY_DOUBLE = 0, //!< plain double arithmetic, inlined
+     GEOMETRY_FLOAT,      //!< single precision, never taking an uncovered site for covered
+     GEOMETRY_CGAL        //!< the CGAL EPICK kernel and long double strips, for reference
    };
-   typedef CGAL::Exact_predicates_inexact_constructions_kernel Kernel;
+   typedef UdcCgalGeometry::Kernel Kernel;
    typedef Kernel::Point_3   Point_3;
    typedef Kernel::Point_2   Point_2;
    typedef Kernel::Segment_2 Segment_2;
 
+  /**
+   * Gateway positions added and removed by an incremental update
+   */
+  struct CoverDelta
+  {
+    std::vector<Vector> added;   //!< positions appended to the cover
+    std::vector<Vector> removed; //!< positions taken out of the cover
+  };
+
+  /**
+   * How one algorithm of a PORTFOLIO cover went
+   */
+  struct PortfolioRun
+  {
+    Algorithm algorithm = FAST_COVER; //!< the algorithm run
+    bool finished = false; //!< it finished before the deadline
+    bool chosen = false;   //!< its cover is the one kept
+    double seconds = 0;    //!< wall-clock time it ran for
+    uint32_t disks = 0;    //!< disks placed, if it finished
+  };
+
+  /**
+   * Result of checking the cover against the sites
+   */
+  struct CoverReport
+  {
+    static const size_t MAX_REPORTED = 1000; //!< uncovered sites listed at most
+    static const size_t MAX_COVERAGE = 16;   //!< last histogram bucket, for this many disks or more
+
+    uint64_t sites = 0;     //!< sites checked
+    uint64_t uncovered = 0; //!< sites outside every disk
+    double maxDistance = 0; //!< largest distance from a site to its nearest disk center
+    std::vector<uint64_t> coverage; //!< coverage[k]: sites inside k disks
+    std::vector<uint32_t> uncoveredSites; //!< the lowest indices of uncovered sites
+  };
+
+  /**
+   * TracedCallback signature for the stats of a finished cover.
+   *
+   * \param [in] stats the times and counts of the cover, see GetStats
+   */
+  typedef void (* CoverStatsCallback) (const UdcCoverStats& stats);
+
   /**
    * Register this type with the TypeId system.
    * \return the object TypeId
    */
   static TypeId GetTypeId (void);
 
+  UDCPositionAllocator ();
+  virtual ~UDCPositionAllocator ();
+
   void SetAlgorithm (int method);
 
+  /**
+   * \brief Take the sites to cover from the positions of the given nodes
+   */
   void SetSites (NodeContainer c);
 
   /**
-   * \brief Compute a unit disk cover approximation to cover the points
+   * \brief Cover sites held in the caller's coordinate buffers
+   *
+   * The buffers are used in place, not copied, so they must stay valid
+   * and unchanged while the allocator uses them.  AddSite appends to them
+   * without copying them, and RemoveSite copies them once, see AddSite and
+   * RemoveSite.
+   *
+   * \param x the x coordinate of every site
+   * \param y the y coordinate of every site
+   * \param n the number of sites
+   */
+  void SetSites (const double* x, const double* y, size_t n);
+
+  /**
+   * \brief Memory-map the sites to cover from a binary site file
+   *
+   * See UdcSiteStore::MapFile for the format, and UdcSiteStore::WriteFile
+   * to produce one.
+   *
+   * \param filename the site file
+   * \return false, leaving the sites unchanged, if the file is unreadable
+   */
+  bool SetSitesFromFile (const std::string& filename);
+
+  /**
+   * \brief Compute a unit disk cover approximation to cover the points,
+   * replacing the current cover
+   *
+   * With the CacheDirectory attribute set, the cover is first looked up
+   * there, under a hash of the stored sites and of the settings that
+   * decide the cover, and is only computed, then stored, if it is not
+   * found.  See UdcCoverCache.
+   *
+   * With the RecordAssignment attribute set, the gateway each site is
+   * assigned to while it is covered is kept too, see GetAssignment, and
+   * the cache is not used.
+   *
    * \param allocator the points that must be covered
    * \param radius the radius of the unit disk or coverage area
    */
   void CoverSites (double radius);
 
-  void Print ();
+  /**
+   * \brief Cover the sites once for each of several radii, in parallel
+   *
+   * Each radius is covered as CoverSites would cover it, on an allocator
+   * of its own that shares the sites of this one, so the sites are
+   * stored once and sorted once for all the radii.  With the Components
+   * attribute, the components are found once, at the largest radius, and
+   * every radius covers each of them separately.  The cover of this
+   * allocator is left unchanged.
+   *
+   * \param radii the radii to cover with
+   * \return the disk centers for each radius, in the order of radii
+   */
+  std::vector<std::vector<Vector>> CoverRadii (const std::vector<double>& radii);
+
+  /**
+   * \brief Add one site and extend the current cover to reach it
+   *
+   * Only the disks near the site are examined.  If none of them covers
+   * the site, one disk is added: at the center of the site's lattice cell
+   * for FAST_COVER and FAST_COVER_HEX, as FastCover would place it, and at
+   * the site itself otherwise, as the sweeps would.  CoverSites must have been called.
+   *
+   * The first AddSite or RemoveSite after CoverSites indexes every site
+   * and disk in hash grids, once, in O(n) time and memory for n sites;
+   * each call after that takes time in the number of sites and disks
+   * near the site.  The site is appended to the stored sites without
+   * copying them, whether they are borrowed or compacted; the next
+   * CoverSites stores them all at the SitePrecision again.
+   *
+   * \param site the position of the new site
+   * \return the gateway positions added
+   */
+  CoverDelta AddSite (const Vector& site);
+
+  /**
+   * \brief Remove a site given earlier through SetSites or AddSite
+   *
+   * Removing a disk moves the last position of the cover into its slot,
+   * so positions keep their order otherwise.  Like AddSite, the first
+   * call indexes the sites and the cover once.  The last site moves into
+   * the slot of the removed one, which copies the sites once if they are
+   * borrowed, see UdcSiteStore::SwapRemove.
+   *
+   * \param site the position of the site, matched to the nearest stored
+   *        site within UdcSiteStore::GetMaxError of it, so that a site
+   *        stored at a lower SitePrecision is still found
+   * \param dropEmpty also remove the disks that no longer cover any site
+   * \return the gateway positions removed
+   */
+  CoverDelta RemoveSite (const Vector& site, bool dropEmpty = true);
+
+  /**
+   * \brief Check that every site lies in some disk of the cover
+   *
+   * The disks are put in a grid of cells one radius wide, and the sites
+   * are checked against the disks in the 3x3 cells around them, in
+   * parallel, in linear time.  Only uncovered sites, which should not
+   * exist, search the rings of cells further out for their nearest disk,
+   * stopping at the first ring too far to hold a nearer one, so a broken
+   * cover costs about the area of the holes in cells rather than a scan
+   * of every disk per site.
+   *
+   * The sites are checked as stored, against the radius less the storage
+   * error, which certifies the cover of the sites as given.
+   *
+   * \return the number of uncovered sites, the largest site to nearest
+   *         center distance and how many disks cover each site
+   */
+  CoverReport VerifyCover (void);
+
+  /**
+   * \brief Remove the disks whose sites are all covered by other disks
+   *
+   * Every site is counted against the disks within reach of it in a grid
+   * of the disks, giving the sites of each disk and the number of disks
+   * covering each site.  The disks are then visited from the fewest sites
+   * up, and a disk is removed when each of its sites is still covered by
+   * another disk.  The remaining positions keep their order.
+   *
+   * \return the number of disks removed
+   */
+  uint32_t PruneRedundant (void);
+
+  /**
+   * \return how each algorithm of the last PORTFOLIO cover went:
+   * FAST_COVER, FAST_COVER_HEX, SWEEP and STRIPS, in that order
+   */
+  const std::vector<PortfolioRun>& GetPortfolioRuns (void) const;
+
+  /**
+   * \brief Where the time of the last CoverSites went, and counts of the
+   * work the algorithm did
+   *
+   * The same stats are passed to the CoverStats trace source as each
+   * CoverSites finishes.  With the Components attribute, the times and
+   * counts of the jobs are added up, so the times are of all the threads
+   * together; PORTFOLIO keeps those of the cover it keeps.  A cover read
+   * from the cache has its CACHE and later phases only.  Every time and
+   * count is 0 when built with UDC_STATS set to 0, see udc-cover-stats.h.
+   *
+   * \return the stats, valid until the next CoverSites
+   */
+  const UdcCoverStats& GetStats (void) const;
+
+  /**
+   * \brief The gateway of each site, and the sites of each gateway, as
+   * decided by the algorithm of the last CoverSites
+   *
+   * Kept only with the RecordAssignment attribute set, and empty
+   * otherwise.  Sites are numbered in the order they were given and
+   * gateways in the order of GetPositions.  The algorithms note the
+   * gateway of each site as they find it covered, so no distance is
+   * computed for the assignment; STRIPS replays the strip pass it kept.
+   * PruneRedundant moves the sites of a disk it removes to a remaining
+   * disk that covers them.  AddSite, RemoveSite and CoverRadii do not
+   * assign sites, and the first two clear the assignment.
+   *
+   * \return the assignment, valid until the next CoverSites, AddSite or
+   *         RemoveSite
+   */
+  const UdcAssignment& GetAssignment (void) const;
+
+  /**
+   * \brief The gateways of the cover, indexed for nearest, k nearest and
+   * range queries
+   *
+   * CoverSites builds the index as it finishes, over a grid of cells one
+   * radius wide, the scale of the cover, and it is built again on first
+   * use after the cover changes otherwise.
+   *
+   * GetGatewayIndex, FindNearestGateways, FindGatewaysWithin and the
+   * queries of the index may be called from any number of threads at
+   * once; the first caller after a change builds the index while the rest
+   * wait for it, and batch queries from different threads take turns on
+   * the worker pool.  None of them may run at the same time as a call
+   * that changes the cover: CoverSites, AddSite, RemoveSite,
+   * PruneRedundant, or setting an attribute.
+   *
+   * \return the index, valid until the cover next changes
+   */
+  const UdcGatewayIndex& GetGatewayIndex (void) const;
+
+  /**
+   * \brief Find the k nearest gateways of each of n points, on the
+   * worker pool
+   *
+   * \param x the x coordinate of every point
+   * \param y the y coordinate of every point
+   * \param n the number of points
+   * \param k the number of gateways per point
+   * \param gateways where the k gateways of point i go, at i * k, nearest
+   *        first, padded with UdcGatewayIndex::NONE
+   */
+  void FindNearestGateways (const double* x, const double* y, size_t n, size_t k, uint32_t* gateways) const;
+
+  /**
+   * \brief Find the gateways within range of each of n points, on the
+   * worker pool
+   *
+   * \param first set to the offset in gateways of the gateways of each
+   *        point, and the end
+   * \param gateways set to the gateways of every point, point by point
+   */
+  void FindGatewaysWithin (const double* x, const double* y, size_t n, double range,
+                           std::vector<uint64_t>& first, std::vector<uint32_t>& gateways) const;
+
+  /**
+   * \brief Cover the sites of a site file too large to hold in memory
+   *
+   * The sites are sorted on x by a UdcExternalSort within the MemoryBudget
+   * attribute, then streamed once through the selected algorithm, which
+   * writes each disk center to diskFile, in the site file format, as it is
+   * placed.  SWEEP and STRIPS keep only the disks and the strip within
+   * reach of the sweep line, and FAST_COVER and FAST_COVER_HEX the lattice
+   * cells of the last few columns, so past the sort the memory used grows
+   * with the density of the sites, not with their number.  SWEEP sizes its
+   * bands to a quarter of the MemoryBudget and drops each disk as the
+   * sweep line passes one radius beyond it, and logs a warning if the
+   * disks within that radius alone take more than the budget.  STRIPS
+   * holds the chords of the strip of each of its six shifts, and logs a
+   * warning if those take more than the budget.
+   *
+   * SWEEP and STRIPS place the disks CoverSites would with the Double
+   * geometry, in the same order: they always take distances in double
+   * arithmetic, STRIPS through UdcDoubleGeometry, and ignore the Geometry
+   * attribute.  PORTFOLIO
+   * streams FAST_COVER.
+   * The lattice algorithms place their disks in order of x, and as the
+   * cells right of a site are not known yet, can end up with a slightly
+   * different cover.
+   *
+   * The sites are read as doubles, whatever the SitePrecision, and the
+   * cover of the allocator is left unchanged.  Temporary files are
+   * created beside diskFile.
+   *
+   * \param siteFile the sites, in the format of UdcSiteStore::MapFile
+   * \param radius the radius of the disks
+   * \param diskFile the file to write the disk centers to
+   * \return false if a file cannot be read or written
+   */
+  bool CoverSiteFile (const std::string& siteFile, double radius, const std::string& diskFile);
+
+  /**
+   * \brief Draw the sites and the cover to an SVG file, on a thread of
+   * its own
+   *
+   * The sites and disks are taken now, each drawn one by one up to the
+   * LayoutPointBudget attribute and otherwise as tiles shaded by density,
+   * see UdcLayout, so the file stays small whatever the number of sites.
+   * Only taking them waits for the sites to be counted into the tiles;
+   * the file is written while the simulation goes on, and no other
+   * program is run.  The next ExportLayout, and the destructor, wait for
+   * the file first.
+   *
+   * \param path the file to write, replaced once complete
+   */
+  void ExportLayout (const std::string& path);
+
+  /**
+   * \brief Wait for the file of the last ExportLayout to be written,
+   * logging a warning if it could not be
+   *
+   * \return false if it could not be written
+   */
+  bool WaitForExport (void);
 
   /**
    * Return the number of positions stored.  Note that this will not change
@@ -87,40 +438,183 @@ public:
    */
   uint32_t GetSize (void) const;
   uint32_t GetSitesN (void) const;
+
+  /**
+   * \brief Return the next position of the cover, from the first after
+   * the cover changes, wrapping around at the end
+   *
+   * Safe to call from several threads at once: each call takes a
+   * position of its own, in order.
+   */
   virtual Vector GetNext (void) const;
+
+  /**
+   * \return the positions of the cover, in place, valid until the cover
+   * next changes
+   */
+  const std::vector<Vector>& GetPositions (void) const;
+
+  /**
+   * \brief Create one node per position of the cover, each with a
+   * ConstantPositionMobilityModel at its position
+   *
+   * Nothing goes through GetNext, whose position is left unchanged.
+   *
+   * \return the new nodes, in the order of the positions
+   */
+  NodeContainer CreateGateways (void) const;
   virtual int64_t AssignStreams (int64_t stream);
 private:
 
   /**
-   * \brief Perform the Ghosh et al algorithm on the sites in the given node container
+   * \brief Run the selected algorithm on all the sites, through UdcCover
+   * unless it is PORTFOLIO
+   */
+  void RunAlgorithm (double radius);
+
+  /**
+   * \brief Run the selected algorithm on groups of sites in parallel
+   *
+   * Sites more than two radii apart can never share a disk, so the sites
+   * are split into the components linked at that distance, the components
+   * are packed in order into jobs of a few thousand sites or more, and
+   * the jobs are covered on a work-stealing pool.  The disks come out job
+   * by job, in the order of the first site of each job.
+   */
+  void ComponentCover (double radius);
+
+  /**
+   * \return the first component of each job of ComponentCover, and the
+   * end: the components in order, in jobs of a few thousand sites or more
    */
-  void FastCover (double radius);
+  std::vector<size_t> PackComponents (const UdcComponents& components) const;
 
   /**
-   * \brief Perform the Biniaz et al algorithm on the sites in the given node container
+   * \return a new allocator for part of the work of this one, running
+   * the same algorithm
+   */
+  Ptr<UDCPositionAllocator> CreateWorker (void) const;
+
+  /**
+   * \brief Run every algorithm on the sites at once, and keep the fewest disks
+   *
+   * Each algorithm runs on an allocator of its own that shares the sites,
+   * on a thread of its own, so all of them run at once whatever the
+   * Threads attribute, and each runs serially.  All but FAST_COVER, which
+   * always finishes so that there is a cover, give up once the
+   * PortfolioDeadline has passed.  The smallest cover finished in time
+   * is kept.
    */
-  void BLMS (double radius);
+  void Portfolio (void);
 
   /**
-   * \brief Perform the Liu-Li algorithm on the sites in the given node container
+   * \return true, from then on, once the deadline of this allocator has
+   * passed; the algorithms check it every few thousand sites and give up
    */
-  void LL (double radius);
+  bool Cancelled (void);
 
   /**
    * \brief Add a position to the list of positions
    * \param v the position to append at the end of the list of positions to return from GetNext.
    */
   void Add (Vector v);
-  double SquaredDistance (const Vector& l, const Vector& r);
+
+  /**
+   * \brief Recompute m_bounds and drop what was derived from the old sites
+   */
+  void SitesChanged (void);
+
+  /**
+   * \brief Index the disk centers in a grid that reaches every site the
+   * disks cover, laid over m_bounds rather than the bounds of the disks
+   */
+  void BuildDiskGrid (UdcDiskGrid& grid) const;
+
+  /**
+   * \brief Store m_sites at m_sitePrecision, or at a finer precision if
+   * that would err by more than a small part of radius, widening m_bounds
+   * by the error this introduces
+   *
+   * \param radius the radius the sites are to be covered with, 0 if not
+   *        known yet, which keeps them as doubles
+   */
+  void CompactSites (double radius);
+
+  struct IncrementalIndex;
+
+  /**
+   * \return the grids behind AddSite and RemoveSite, built from the
+   * current sites and cover on first use
+   */
+  IncrementalIndex& GetIncrementalIndex (void);
+
+  /**
+   * \brief Remove a disk from the cover and the incremental index
+   * \param disk the index of the disk in m_positions
+   */
+  void RemoveDisk (uint32_t disk);
+
+  /**
+   * \brief The sites sorted on x, at the precision of m_sites, built on
+   * first use and kept until the sites change
+   */
+  const UdcSiteStore& GetSortedSites (void);
+
+  /**
+   * \return what, besides the sites, decides the cover CoverSites
+   * computes, for the cover cache key
+   */
+  std::vector<uint64_t> GetCacheParameters (void) const;
+
+  /**
+   * \return the radius to cover the stored sites with, so that disks of
+   * m_radius cover the sites as given
+   */
+  double GetEffectiveRadius (void) const;
+
+  /**
+   * \return the worker pool sized by the Threads attribute, created on
+   * first use by whichever thread gets here first
+   */
+  UdcThreadPool& GetThreadPool (void) const;
 
   Algorithm m_method = Algorithm(0); // set default to the first value given in the enum
-  size_t m_maxCoverageSites = 50000;
   double m_defaultHeight = 1.2;
-  double m_radius; //!< the radius of the unit disk (coverage area)
+  SweepEngine m_sweepEngine = SWEEP_TREE; //!< active-set structure used by BLMS
+  Geometry m_geometry = GEOMETRY_DOUBLE; //!< policy the algorithms take distances in
+  bool m_verify = false; //!< run VerifyCover after every CoverSites
+  bool m_prune = false; //!< run PruneRedundant after every CoverSites
+  bool m_components = false; //!< cover the components of the sites separately
+  uint32_t m_threads = 1; //!< number of worker threads, 0 for one per hardware thread
+  uint64_t m_minBandSites = uint64_t (1) << 20; //!< fewest sites in a band of a parallel FAST_COVER
+  uint64_t m_memoryBudget = uint64_t (1) << 30; //!< bytes CoverSiteFile may sort and sweep in
+  std::string m_cacheDirectory; //!< where covers are kept across runs, empty for nowhere
+  Time m_portfolioDeadline; //!< wall-clock limit of a PORTFOLIO cover, zero for none
+  std::vector<PortfolioRun> m_portfolioRuns; //!< the runs of the last PORTFOLIO cover
+  bool m_stoppable = false; //!< the algorithms give up at m_stopAt
+  std::chrono::steady_clock::time_point m_stopAt; //!< when to give up, if m_stoppable
+  std::atomic<bool> m_cancelled {false}; //!< the last algorithm gave up
+  mutable std::mutex m_poolMutex; //!< guards creating m_pool
+  mutable std::unique_ptr<UdcThreadPool> m_pool; //!< workers, created on first parallel use
+  std::unique_ptr<IncrementalIndex> m_incremental; //!< AddSite/RemoveSite grids, null until needed
+  double m_radius = 0; //!< the radius of the unit disk (coverage area)
   std::vector<Vector> m_bounds; //!< the bounds of the given collection of sites
-  std::vector<Vector> m_sites; //!< sites to cover
+  UdcSiteStore m_sites; //!< sites to cover
+  UdcSiteStore m_sortedSites; //!< m_sites sorted on x, empty until needed
+  std::shared_ptr<const std::vector<uint32_t>> m_sortOrder; //!< the index in m_sites of each of m_sortedSites, kept to record the assignment
+  bool m_recordAssignment = false; //!< keep the gateway of each site in m_assignment
+  UdcAssignment m_assignment; //!< the gateway of each site, if m_recordAssignment
+  mutable std::mutex m_gatewayMutex; //!< guards building m_gatewayIndex
+  mutable UdcGatewayIndex m_gatewayIndex; //!< the gateways of the cover, for queries
+  mutable std::atomic<bool> m_gatewayIndexed {false}; //!< m_gatewayIndex holds the current cover
+  UdcSiteStore::Precision m_sitePrecision = UdcSiteStore::DOUBLE; //!< storage precision of the sites
   std::vector<Vector> m_positions;  //!< vector of positions
-  mutable std::vector<Vector>::const_iterator m_current; //!< vector iterator
+  mutable std::atomic<uint64_t> m_next {0}; //!< position GetNext returns next, modulo their number
+  UdcCoverStats m_stats; //!< times and counts of the last CoverSites
+  uint32_t m_layoutPointBudget = 100000; //!< most points ExportLayout draws one by one
+  std::future<bool> m_export; //!< the file ExportLayout is writing, if any
+  std::string m_exportPath; //!< the file of the last ExportLayout
+  TracedCallback<const UdcCoverStats&> m_coverStatsTrace; //!< fired with m_stats as CoverSites finishes
 };
 
 
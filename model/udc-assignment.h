@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_ASSIGNMENT_H
+#define UDC_ASSIGNMENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief The gateway each site was assigned to while it was covered, and
+ * the sites of each gateway.
+ *
+ * The algorithms note the gateway of a site as they decide that it is
+ * covered, so every site has exactly one gateway, whose disk covers it.
+ * Build then groups the sites by gateway, in compressed sparse row form:
+ * the sites of gateway g are GetSites (g)[0] to GetSites (g)[GetSize (g) - 1],
+ * in input order.
+ */
+class UdcAssignment
+{
+public:
+  static constexpr uint32_t NONE = UINT32_MAX; //!< the gateway of a site not assigned yet
+
+  /**
+   * \brief Forget every site and gateway.
+   */
+  void Clear (void)
+  {
+    m_gateway.clear ();
+    m_first.assign (1, 0);
+    m_sites.clear ();
+  }
+
+  /**
+   * \brief Start over with the given number of sites, none assigned.
+   */
+  void Reset (size_t sites)
+  {
+    Clear ();
+    m_gateway.assign (sites, NONE);
+  }
+
+  /**
+   * \return true if there are no sites
+   */
+  bool IsEmpty (void) const
+  {
+    return m_gateway.empty ();
+  }
+
+  /**
+   * \brief Assign a site to a gateway, replacing its gateway if it had one.
+   *
+   * Sites may be assigned from several threads at once, as long as no two
+   * assign the same site.  Build must be called again afterwards.
+   */
+  void Assign (size_t site, uint32_t gateway)
+  {
+    m_gateway[site] = gateway;
+  }
+
+  /**
+   * \brief Group the assigned sites by gateway.
+   * \param gateways the number of gateways; every assigned gateway is less
+   */
+  void Build (size_t gateways)
+  {
+    m_first.assign (gateways + 1, 0);
+    for (uint32_t g : m_gateway)
+      {
+        if (g != NONE)
+          {
+            ++m_first[g + 1];
+          }
+      }
+    for (size_t g = 0; g < gateways; ++g)
+      {
+        m_first[g + 1] += m_first[g];
+      }
+    std::vector<uint32_t> next (m_first.begin (), m_first.end () - 1);
+    m_sites.resize (m_first[gateways]);
+    for (uint32_t i = 0; i < m_gateway.size (); ++i)
+      {
+        if (m_gateway[i] != NONE)
+          {
+            m_sites[next[m_gateway[i]]++] = i;
+          }
+      }
+  }
+
+  /**
+   * \return the number of sites
+   */
+  size_t GetNSites (void) const
+  {
+    return m_gateway.size ();
+  }
+
+  /**
+   * \return the number of gateways, as of the last Build
+   */
+  size_t GetNGateways (void) const
+  {
+    return m_first.size () - 1;
+  }
+
+  /**
+   * \return the gateway of site i, or NONE
+   */
+  uint32_t GetGateway (size_t i) const
+  {
+    return m_gateway[i];
+  }
+
+  /**
+   * \return the number of sites of gateway g
+   */
+  size_t GetSize (size_t g) const
+  {
+    return m_first[g + 1] - m_first[g];
+  }
+
+  /**
+   * \return the sites of gateway g, in input order
+   */
+  const uint32_t *GetSites (size_t g) const
+  {
+    return m_sites.data () + m_first[g];
+  }
+
+private:
+  std::vector<uint32_t> m_gateway;   //!< the gateway of each site
+  std::vector<uint32_t> m_first {0}; //!< offset of each gateway in m_sites, and the end
+  std::vector<uint32_t> m_sites;     //!< site indices grouped by gateway
+};
+
+} // namespace ns3
+
+#endif /* UDC_ASSIGNMENT_H */
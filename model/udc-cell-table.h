@@ -0,0 +1,275 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_CELL_TABLE_H
+#define UDC_CELL_TABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief Set of occupied lattice cells, keyed by (vertical, horizontal).
+ *
+ * Cells are packed into 64-bit keys and stored in a flat open-addressing
+ * table with linear probing, so a lookup is a hash and a short scan of
+ * one cache line.  Each index must fit in 32 bits.  When the cells are
+ * known to lie in a small box the table is a dense bitmap over that box
+ * instead.  A bitmap falls back to hashing if a cell outside its box is
+ * inserted.
+ */
+class LatticeCellTable
+{
+public:
+  LatticeCellTable ()
+  {
+    Reset (0);
+  }
+
+  /**
+   * \brief Empty the table and size it for the cells to come.
+   * \param expected an upper bound on the number of cells to be inserted,
+   *        e.g. the number of sites
+   * \param minV,maxV,minH,maxH the box holding every inserted cell
+   */
+  void Reserve (size_t expected, int64_t minV, int64_t maxV, int64_t minH, int64_t maxH)
+  {
+    const uint64_t columns = maxV - minV + 1, rows = maxH - minH + 1;
+    const bool small = maxV >= minV && maxH >= minH && columns <= (UINT64_MAX >> 8) / rows
+      && columns * rows <= std::max<uint64_t> (DENSE_BITS, 64 * uint64_t (expected));
+    if (small)
+      {
+        m_dense = true;
+        m_minV = minV;
+        m_minH = minH;
+        m_columns = columns;
+        m_rows = rows;
+        m_size = 0;
+        m_bits.assign ((columns * rows + 63) / 64, 0);
+        m_keys.clear ();
+        m_keys.shrink_to_fit ();
+        return;
+      }
+    const uint64_t boxCells = maxV >= minV && maxH >= minH && columns <= UINT64_MAX / rows ? columns * rows : UINT64_MAX;
+    Reset (std::min<uint64_t> (std::min<uint64_t> (expected, boxCells), MAX_RESERVE));
+  }
+
+  /**
+   * \return true if the cell has been inserted
+   */
+  bool Contains (int64_t vertical, int64_t horizontal) const
+  {
+    if (m_dense)
+      {
+        uint64_t bit;
+        return DenseIndex (vertical, horizontal, bit) && (m_bits[bit >> 6] >> (bit & 63) & 1);
+      }
+    const uint64_t key = Pack (vertical, horizontal);
+    if (key == EMPTY)
+      {
+        return m_hasEmptyKey;
+      }
+    for (uint64_t slot = Mix (key) & m_mask;; slot = (slot + 1) & m_mask)
+      {
+        if (m_keys[slot] == key)
+          {
+            return true;
+          }
+        if (m_keys[slot] == EMPTY)
+          {
+            return false;
+          }
+      }
+  }
+
+  /**
+   * \return true if the cell was not present before
+   */
+  bool Insert (int64_t vertical, int64_t horizontal)
+  {
+    if (m_dense)
+      {
+        uint64_t bit;
+        if (DenseIndex (vertical, horizontal, bit))
+          {
+            uint64_t &word = m_bits[bit >> 6];
+            const uint64_t mask = uint64_t (1) << (bit & 63);
+            if (word & mask)
+              {
+                return false;
+              }
+            word |= mask;
+            ++m_size;
+            return true;
+          }
+        MoveToHashing ();
+      }
+    const uint64_t key = Pack (vertical, horizontal);
+    if (key == EMPTY)
+      {
+        if (m_hasEmptyKey)
+          {
+            return false;
+          }
+        m_hasEmptyKey = true;
+        ++m_size;
+        return true;
+      }
+    if ((m_size + 1) * 4 > (m_mask + 1) * 3)
+      {
+        Rehash ((m_mask + 1) * 2);
+      }
+    return InsertKey (key);
+  }
+
+  /**
+   * \return the number of cells inserted
+   */
+  size_t GetSize (void) const
+  {
+    return m_size;
+  }
+
+  /**
+   * \return the bytes of the bitmap or the open-addressed keys
+   */
+  size_t GetBytes (void) const
+  {
+    return m_bits.capacity () * sizeof (uint64_t) + m_keys.capacity () * sizeof (uint64_t);
+  }
+
+  /**
+   * \return the packed 64-bit key of a cell
+   */
+  static uint64_t Pack (int64_t vertical, int64_t horizontal)
+  {
+    return uint64_t (uint32_t (vertical)) << 32 | uint32_t (horizontal);
+  }
+
+private:
+  static constexpr uint64_t EMPTY = UINT64_MAX;
+  static constexpr uint64_t DENSE_BITS = uint64_t (1) << 24; //!< 2 MB of bitmap is always fine
+  static constexpr uint64_t MAX_RESERVE = uint64_t (1) << 24; //!< cap on up-front slots
+
+  /**
+   * The finalizer of MurmurHash3; neighboring cells land far apart.
+   */
+  static uint64_t Mix (uint64_t k)
+  {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+  }
+
+  bool DenseIndex (int64_t vertical, int64_t horizontal, uint64_t &bit) const
+  {
+    const uint64_t column = vertical - m_minV, row = horizontal - m_minH;
+    if (column >= m_columns || row >= m_rows)
+      {
+        return false;
+      }
+    bit = column * m_rows + row;
+    return true;
+  }
+
+  void Reset (uint64_t expected)
+  {
+    uint64_t slots = 16;
+    while (slots * 3 < expected * 4)
+      {
+        slots *= 2;
+      }
+    m_dense = false;
+    m_bits.clear ();
+    m_bits.shrink_to_fit ();
+    m_keys.assign (slots, EMPTY);
+    m_mask = slots - 1;
+    m_size = 0;
+    m_hasEmptyKey = false;
+  }
+
+  bool InsertKey (uint64_t key)
+  {
+    for (uint64_t slot = Mix (key) & m_mask;; slot = (slot + 1) & m_mask)
+      {
+        if (m_keys[slot] == key)
+          {
+            return false;
+          }
+        if (m_keys[slot] == EMPTY)
+          {
+            m_keys[slot] = key;
+            ++m_size;
+            return true;
+          }
+      }
+  }
+
+  void Rehash (uint64_t slots)
+  {
+    std::vector<uint64_t> old (slots, EMPTY);
+    old.swap (m_keys);
+    m_mask = slots - 1;
+    m_size = m_hasEmptyKey;
+    for (uint64_t key : old)
+      {
+        if (key != EMPTY)
+          {
+            InsertKey (key);
+          }
+      }
+  }
+
+  void MoveToHashing (void)
+  {
+    std::vector<uint64_t> bits;
+    bits.swap (m_bits);
+    const int64_t minV = m_minV, minH = m_minH;
+    const uint64_t rows = m_rows;
+    Reset (m_size * 2);
+    for (uint64_t w = 0; w < bits.size (); ++w)
+      {
+        for (uint64_t word = bits[w]; word; word &= word - 1)
+          {
+            const uint64_t bit = w * 64 + __builtin_ctzll (word);
+            Insert (minV + int64_t (bit / rows), minH + int64_t (bit % rows));
+          }
+      }
+  }
+
+  bool m_dense;
+  std::vector<uint64_t> m_bits; //!< dense mode: one bit per cell of the box
+  int64_t m_minV = 0, m_minH = 0;
+  uint64_t m_columns = 0, m_rows = 0;
+  std::vector<uint64_t> m_keys; //!< hash mode: packed keys, EMPTY for a free slot
+  uint64_t m_mask;
+  size_t m_size;
+  bool m_hasEmptyKey; //!< the key equal to EMPTY lives outside the slots
+};
+
+} // namespace ns3
+
+#endif /* UDC_CELL_TABLE_H */
@@ -0,0 +1,60 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_CGAL_GEOMETRY_H
+#define UDC_CGAL_GEOMETRY_H
+
+#include <cmath>
+
+#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+#include <CGAL/squared_distance_2.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief Geometry through the CGAL EPICK kernel, the reference policy of
+ * the UdcCover algorithms, see udc-geometry.h.
+ *
+ * Distances are taken between CGAL points built for the purpose, and the
+ * strips of LL are placed in long double, as the algorithms did before
+ * they took a policy.  Kept to measure the other policies against.
+ */
+struct UdcCgalGeometry
+{
+  typedef CGAL::Exact_predicates_inexact_constructions_kernel Kernel;
+  typedef Kernel::Point_2 Point_2;
+
+  typedef double Real;
+  typedef long double Strip;
+
+  static double SquaredDistance (double ax, double ay, double bx, double by)
+  {
+    return CGAL::squared_distance (Point_2 (ax, ay), Point_2 (bx, by));
+  }
+
+  static long double Chord (double radius, long double distance)
+  {
+    return std::sqrt (std::pow (radius, 2) - distance * distance);
+  }
+};
+
+} // namespace ns3
+
+#endif /* UDC_CGAL_GEOMETRY_H */
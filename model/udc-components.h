@@ -0,0 +1,302 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_COMPONENTS_H
+#define UDC_COMPONENTS_H
+
+#include "udc-radix-sort.h"
+#include "udc-site-store.h"
+#include "udc-thread-pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief The groups of sites linked by chains of sites at most a given
+ * distance apart.
+ *
+ * The sites are sorted into square cells whose diagonal is the distance,
+ * so the sites of a cell are always linked, and the union-find runs over
+ * cells.  Two cells up to two apart are joined, unless they already are,
+ * as soon as one pair of their sites is close enough.  Only the sites of
+ * each cell within reach of the bounding box of the other are paired, in
+ * order of x, each with the sites of the other cell less than the
+ * distance away on x.
+ *
+ * Components are numbered in the order of their first site, and each
+ * lists its sites in input order.
+ */
+class UdcComponents
+{
+public:
+  /**
+   * \param sites the sites to group
+   * \param minX,minY a corner below and left of every site
+   * \param reach the largest distance between linked sites
+   * \param pool the workers to sort with
+   */
+  void Build (const UdcSiteStore &sites, double minX, double minY, double reach, UdcThreadPool &pool)
+  {
+    const size_t n = sites.GetN ();
+    m_first.assign (1, 0);
+    m_sites.clear ();
+    if (n == 0)
+      {
+        return;
+      }
+
+    // Sort the sites by cell, row-major
+    const double width = reach / std::sqrt (2.0);
+    std::vector<int64_t> column (n), row (n);
+    int64_t columns = 1;
+    for (size_t i = 0; i < n; ++i)
+      {
+        column[i] = int64_t (std::floor ((sites.X (i) - minX) / width));
+        row[i] = int64_t (std::floor ((sites.Y (i) - minY) / width));
+        columns = std::max (columns, column[i] + 3);
+      }
+    auto keyOf = [columns] (int64_t c, int64_t r) { return double (r * columns + c); };
+
+    std::vector<uint32_t> order (n);
+    for (uint32_t i = 0; i < n; ++i)
+      {
+        order[i] = i;
+      }
+    ParallelRadixSort (order, [&] (uint32_t i) { return keyOf (column[i], row[i]); }, pool);
+
+    // The cells, as runs of the sorted sites
+    std::vector<double> cellKey;
+    std::vector<uint32_t> cellBegin;
+    for (size_t k = 0; k < n; ++k)
+      {
+        const double key = keyOf (column[order[k]], row[order[k]]);
+        if (k == 0 || key != cellKey.back ())
+          {
+            cellKey.push_back (key);
+            cellBegin.push_back (k);
+          }
+      }
+    cellBegin.push_back (n);
+    const size_t cells = cellKey.size ();
+
+    // The sites of each cell in order of x, and the box around them
+    struct Box
+    {
+      double minX, minY, maxX, maxY;
+    };
+    std::vector<double> xs (n), ys (n);
+    std::vector<Box> box (cells);
+    const size_t chunks = pool.GetN ();
+    pool.ParallelFor (chunks, [&] (size_t chunk, unsigned) {
+      for (size_t c = cells * chunk / chunks; c < cells * (chunk + 1) / chunks; ++c)
+        {
+          std::sort (order.begin () + cellBegin[c], order.begin () + cellBegin[c + 1],
+                     [&] (uint32_t i, uint32_t j) { return sites.X (i) < sites.X (j); });
+          Box &b = box[c];
+          b = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+          for (uint32_t k = cellBegin[c]; k < cellBegin[c + 1]; ++k)
+            {
+              xs[k] = sites.X (order[k]);
+              ys[k] = sites.Y (order[k]);
+              b = {std::min (b.minX, xs[k]), std::min (b.minY, ys[k]), std::max (b.maxX, xs[k]),
+                   std::max (b.maxY, ys[k])};
+            }
+        }
+    });
+
+    // Join each cell to the cells after it, in row-major order, that are in reach
+    std::vector<uint32_t> parent (cells), size (cells, 1);
+    for (uint32_t c = 0; c < cells; ++c)
+      {
+        parent[c] = c;
+      }
+    auto find = [&parent] (uint32_t c) {
+      while (parent[c] != c)
+        {
+          parent[c] = parent[parent[c]];
+          c = parent[c];
+        }
+      return c;
+    };
+    const double reachSquared = reach * reach * (1 + 1e-9);
+    auto apart = [reachSquared] (const Box &b, double minX, double minY, double maxX, double maxY) {
+      const double dx = std::max ({b.minX - maxX, minX - b.maxX, 0.0}),
+                   dy = std::max ({b.minY - maxY, minY - b.maxY, 0.0});
+      return dx * dx + dy * dy > reachSquared;
+    };
+    // The sites of a cell within reach of the box of another, in order of x
+    std::vector<uint32_t> nearA, nearB;
+    auto near = [&] (uint32_t c, const Box &other, std::vector<uint32_t> &near) {
+      near.clear ();
+      for (uint32_t k = cellBegin[c]; k < cellBegin[c + 1]; ++k)
+        {
+          if (!apart (other, xs[k], ys[k], xs[k], ys[k]))
+            {
+              near.push_back (k);
+            }
+        }
+    };
+    auto linked = [&] (uint32_t a, uint32_t b) {
+      if (apart (box[a], box[b].minX, box[b].minY, box[b].maxX, box[b].maxY))
+        {
+          return false;
+        }
+      near (a, box[b], nearA);
+      near (b, box[a], nearB);
+      // The sites of b less than the reach away on x slide along those of a
+      const double reachX = std::sqrt (reachSquared);
+      size_t first = 0;
+      for (uint32_t k : nearA)
+        {
+          while (first < nearB.size () && xs[nearB[first]] < xs[k] - reachX)
+            {
+              ++first;
+            }
+          for (size_t l = first; l < nearB.size () && xs[nearB[l]] <= xs[k] + reachX; ++l)
+            {
+              const double dx = xs[k] - xs[nearB[l]], dy = ys[k] - ys[nearB[l]];
+              if (dx * dx + dy * dy <= reachSquared)
+                {
+                  return true;
+                }
+            }
+        }
+      return false;
+    };
+
+    // Adjacent cells first, so that most cells two apart are already
+    // joined through them by the time they are compared.  The key of a
+    // given neighbor grows with the cell, so each offset keeps a cursor.
+    for (int far = 0; far <= 1; ++far)
+      {
+        std::vector<std::pair<int, int>> offsets;
+        for (int dr = 0; dr <= 2; ++dr)
+          {
+            for (int dc = dr == 0 ? 1 : -2; dc <= 2; ++dc)
+              {
+                if ((std::max (std::abs (dc), dr) == 2) == bool (far))
+                  {
+                    offsets.emplace_back (dc, dr);
+                  }
+              }
+          }
+        std::vector<size_t> cursor (offsets.size (), 0);
+        for (uint32_t c = 0; c < cells; ++c)
+          {
+            const uint32_t site = order[cellBegin[c]];
+            for (size_t o = 0; o < offsets.size (); ++o)
+              {
+                const double key = keyOf (column[site] + offsets[o].first, row[site] + offsets[o].second);
+                size_t &other = cursor[o];
+                while (other < cells && cellKey[other] < key)
+                  {
+                    ++other;
+                  }
+                if (other == cells || cellKey[other] != key)
+                  {
+                    continue;
+                  }
+                // Union by size
+                uint32_t a = find (c), b = find (other);
+                if (a != b && linked (c, other))
+                  {
+                    if (size[a] < size[b])
+                      {
+                        std::swap (a, b);
+                      }
+                    parent[b] = a;
+                    size[a] += size[b];
+                  }
+              }
+          }
+      }
+
+    // Number the components by their first site, and list their sites
+    std::vector<uint32_t> cellOf (n);
+    for (uint32_t c = 0; c < cells; ++c)
+      {
+        for (uint32_t k = cellBegin[c]; k < cellBegin[c + 1]; ++k)
+          {
+            cellOf[order[k]] = c;
+          }
+      }
+    std::vector<uint32_t> label (cells, UINT32_MAX), count;
+    for (size_t i = 0; i < n; ++i)
+      {
+        uint32_t &l = label[find (cellOf[i])];
+        if (l == UINT32_MAX)
+          {
+            l = count.size ();
+            count.push_back (0);
+          }
+        ++count[l];
+        cellOf[i] = l;
+      }
+    m_first.assign (count.size () + 1, 0);
+    for (size_t l = 0; l < count.size (); ++l)
+      {
+        m_first[l + 1] = m_first[l] + count[l];
+      }
+    std::vector<uint32_t> next (m_first.begin (), m_first.end () - 1);
+    m_sites.resize (n);
+    for (uint32_t i = 0; i < n; ++i)
+      {
+        m_sites[next[cellOf[i]]++] = i;
+      }
+  }
+
+  /**
+   * \return the number of components
+   */
+  size_t GetN (void) const
+  {
+    return m_first.size () - 1;
+  }
+
+  /**
+   * \return the number of sites in component c
+   */
+  size_t GetSize (size_t c) const
+  {
+    return m_first[c + 1] - m_first[c];
+  }
+
+  /**
+   * \return the sites of component c, in input order
+   */
+  const uint32_t *GetSites (size_t c) const
+  {
+    return m_sites.data () + m_first[c];
+  }
+
+private:
+  std::vector<uint32_t> m_first; //!< offset of each component in m_sites, and the end
+  std::vector<uint32_t> m_sites; //!< site indices grouped by component
+};
+
+} // namespace ns3
+
+#endif /* UDC_COMPONENTS_H */
@@ -0,0 +1,210 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#include "udc-cover-cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+static const char COVER_FILE_MAGIC[8] = {'U', 'D', 'C', 'C', 'O', 'V', 'R', '1'};
+
+// Sites hashed per chunk; fixed, so that the key does not depend on the workers
+static const size_t HASH_CHUNK = 1 << 16;
+
+/*
+ * The finalizer of MurmurHash3.
+ */
+static uint64_t
+Mix (uint64_t k)
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+/*
+ * Two independently seeded hash chains over 64-bit words.
+ */
+struct WordHasher
+{
+  void Add (uint64_t word)
+  {
+    high = Mix (high ^ word);
+    low = Mix (low + word * 0x9e3779b97f4a7c15ULL);
+  }
+
+  void Add (double value)
+  {
+    uint64_t word;
+    std::memcpy (&word, &value, sizeof word);
+    Add (word);
+  }
+
+  uint64_t high = 0x243f6a8885a308d3ULL, low = 0x13198a2e03707344ULL;
+};
+
+std::string
+UdcCoverCache::Key::ToString (void) const
+{
+  char text[33];
+  std::snprintf (text, sizeof text, "%016llx%016llx", (unsigned long long) high, (unsigned long long) low);
+  return text;
+}
+
+UdcCoverCache::UdcCoverCache (const std::string &directory)
+  : m_directory (directory)
+{
+  mkdir (m_directory.c_str (), 0755);
+}
+
+UdcCoverCache::Key
+UdcCoverCache::MakeKey (const UdcSiteStore &sites, const std::vector<uint64_t> &parameters, UdcThreadPool &pool)
+{
+  const size_t n = sites.GetN ();
+  const size_t chunks = (n + HASH_CHUNK - 1) / HASH_CHUNK;
+  std::vector<WordHasher> chunkHash (chunks);
+  pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+    const size_t begin = c * HASH_CHUNK, count = std::min (HASH_CHUNK, n - begin);
+    std::vector<double> x (count), y (count);
+    sites.Decode (begin, count, x.data (), y.data ());
+    for (size_t k = 0; k < count; ++k)
+      {
+        chunkHash[c].Add (x[k]);
+        chunkHash[c].Add (y[k]);
+      }
+  });
+
+  WordHasher hash;
+  hash.Add (uint64_t (n));
+  hash.Add (uint64_t (sites.GetPrecision ()));
+  for (uint64_t parameter : parameters)
+    {
+      hash.Add (parameter);
+    }
+  for (const WordHasher &c : chunkHash)
+    {
+      hash.Add (c.high);
+      hash.Add (c.low);
+    }
+  Key key;
+  key.high = hash.high;
+  key.low = hash.low;
+  return key;
+}
+
+bool
+UdcCoverCache::Load (const Key &key, std::vector<Vector> &positions) const
+{
+  std::ifstream in (FileName (key), std::ios::binary | std::ios::ate);
+  if (!in)
+    {
+      return false;
+    }
+  // Magic, key, count, positions and checksum, all 8-byte words
+  const uint64_t size = uint64_t (in.tellg ());
+  if (size < 5 * sizeof (uint64_t) || size % sizeof (uint64_t) != 0
+      || (size / sizeof (uint64_t) - 5) % 3 != 0)
+    {
+      return false;
+    }
+  std::vector<uint64_t> words (size / sizeof (uint64_t));
+  in.seekg (0);
+  if (!in.read (reinterpret_cast<char *> (words.data ()), size))
+    {
+      return false;
+    }
+
+  WordHasher checksum;
+  for (size_t w = 0; w + 1 < words.size (); ++w)
+    {
+      checksum.Add (words[w]);
+    }
+  const uint64_t n = words[3];
+  if (std::memcmp (words.data (), COVER_FILE_MAGIC, sizeof COVER_FILE_MAGIC) != 0
+      || words[1] != key.high || words[2] != key.low
+      || n != (words.size () - 5) / 3
+      || words.back () != (checksum.high ^ checksum.low))
+    {
+      return false;
+    }
+
+  const double *coordinates = reinterpret_cast<const double *> (words.data () + 4);
+  positions.resize (n);
+  for (uint64_t i = 0; i < n; ++i)
+    {
+      positions[i] = Vector (coordinates[3 * i], coordinates[3 * i + 1], coordinates[3 * i + 2]);
+    }
+  return true;
+}
+
+bool
+UdcCoverCache::Store (const Key &key, const std::vector<Vector> &positions) const
+{
+  std::vector<uint64_t> words (5 + 3 * positions.size ());
+  std::memcpy (words.data (), COVER_FILE_MAGIC, sizeof COVER_FILE_MAGIC);
+  words[1] = key.high;
+  words[2] = key.low;
+  words[3] = positions.size ();
+  double *coordinates = reinterpret_cast<double *> (words.data () + 4);
+  for (size_t i = 0; i < positions.size (); ++i)
+    {
+      coordinates[3 * i] = positions[i].x;
+      coordinates[3 * i + 1] = positions[i].y;
+      coordinates[3 * i + 2] = positions[i].z;
+    }
+  WordHasher checksum;
+  for (size_t w = 0; w + 1 < words.size (); ++w)
+    {
+      checksum.Add (words[w]);
+    }
+  words.back () = checksum.high ^ checksum.low;
+
+  // Write beside the final name, then rename over it in one step
+  static std::atomic<unsigned> written (0);
+  const std::string name = FileName (key);
+  const std::string temporary = name + ".tmp" + std::to_string (getpid ()) + "." + std::to_string (written++);
+  std::ofstream out (temporary, std::ios::binary | std::ios::trunc);
+  out.write (reinterpret_cast<const char *> (words.data ()), words.size () * sizeof (uint64_t));
+  out.close ();
+  if (!out || std::rename (temporary.c_str (), name.c_str ()) != 0)
+    {
+      std::remove (temporary.c_str ());
+      return false;
+    }
+  return true;
+}
+
+std::string
+UdcCoverCache::FileName (const Key &key) const
+{
+  return m_directory + "/" + key.ToString () + ".udccover";
+}
+
+} // namespace ns3
@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_COVER_CACHE_H
+#define UDC_COVER_CACHE_H
+
+#include "ns3/vector.h"
+
+#include "udc-site-store.h"
+#include "udc-thread-pool.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief On-disk store of covers, addressed by the sites and the settings
+ * that produced them.
+ *
+ * A cover is filed under a 128-bit key hashed from the sites, as stored,
+ * and the parameters of the cover.  The hash guards against accidental
+ * collisions, not deliberate ones.  Each file repeats its key and ends
+ * with a checksum of everything before it, and Load rejects a file whose
+ * size, key or checksum is wrong, so a truncated or damaged file is never
+ * used.  Store writes a temporary file and renames it into place, so
+ * concurrent runs sharing the directory never see a partial file.
+ *
+ * The file holds the 8 bytes "UDCCOVR1", the two words of the key, the
+ * number of positions n, n positions as x, y and z doubles, and the
+ * checksum, all in host byte order.
+ */
+class UdcCoverCache
+{
+public:
+  /**
+   * A content address
+   */
+  struct Key
+  {
+    uint64_t high = 0, low = 0;
+
+    /**
+     * \return the key as 32 hex digits
+     */
+    std::string ToString (void) const;
+  };
+
+  /**
+   * \param directory where the covers are kept; created if missing
+   */
+  explicit UdcCoverCache (const std::string &directory);
+
+  /**
+   * \brief Hash the sites, in parallel chunks, and the parameters.
+   *
+   * The chunks do not depend on the number of workers, so neither does
+   * the key.
+   */
+  static Key MakeKey (const UdcSiteStore &sites, const std::vector<uint64_t> &parameters, UdcThreadPool &pool);
+
+  /**
+   * \return false, leaving positions unchanged, if there is no intact
+   *         cover for the key
+   */
+  bool Load (const Key &key, std::vector<Vector> &positions) const;
+
+  /**
+   * \return false if the cover could not be written
+   */
+  bool Store (const Key &key, const std::vector<Vector> &positions) const;
+
+private:
+  std::string FileName (const Key &key) const;
+
+  std::string m_directory;
+};
+
+} // namespace ns3
+
+#endif /* UDC_COVER_CACHE_H */
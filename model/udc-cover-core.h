@@ -0,0 +1,1425 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_COVER_CORE_H
+#define UDC_COVER_CORE_H
+
+#include "udc-assignment.h"
+#include "udc-cell-table.h"
+#include "udc-cover-stats.h"
+#include "udc-geometry.h"
+#include "udc-radix-sort.h"
+#include "udc-simd.h"
+#include "udc-site-store.h"
+#include "udc-sweep-buckets.h"
+#include "udc-thread-pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/*
+ * Lattice constants of the Ghosh et al. algorithm for a given radius.  A
+ * site can only be within the radius of the center of the next cell along
+ * an axis if it lies at least nextReach past the start of its own cell on
+ * that axis, and of the previous cell if it lies at most previousReach past it.
+ */
+struct FastCoverLattice
+{
+  explicit FastCoverLattice (double radius)
+    : radiusSquared (radius * radius),
+      gridWidth (std::sqrt (2) * radius),
+      additiveFactor (gridWidth / 2),
+      nextReach (gridWidth * 1.5 - radius),
+      previousReach (radius - gridWidth * 0.5)
+  {
+  }
+
+  int Cell (double coordinate) const
+  {
+    return floor (coordinate / gridWidth);
+  }
+
+  double radiusSquared, gridWidth, additiveFactor, nextReach, previousReach;
+};
+
+/*
+ * Hexagonal lattice of HexFastCover: pointy-top hexagons with the radius
+ * as circumradius, in axial coordinates (q,s).  Hexagon (q,s) is centered
+ * at (sqrt(3)*(q+s/2), 1.5*s)*radius, and all of it lies within the
+ * radius of its center.
+ */
+struct HexLattice
+{
+  explicit HexLattice (double radius)
+    : radiusSquared (radius * radius),
+      innerSquared ((4 - 2 * std::sqrt (3)) * radiusSquared),
+      width (std::sqrt (3) * radius),
+      rowHeight (1.5 * radius)
+  {
+  }
+
+  // The hexagon holding (x,y), by rounding the fractional cube coordinates
+  void Cell (double x, double y, int &q, int &s) const
+  {
+    const double fs = y / rowHeight, fq = x / width - fs / 2, fr = -fq - fs;
+    double rq = std::floor (fq + 0.5), rs = std::floor (fs + 0.5);
+    const double rr = std::floor (fr + 0.5);
+    const double dq = std::fabs (rq - fq), ds = std::fabs (rs - fs), dr = std::fabs (rr - fr);
+    if (dq > ds && dq > dr)
+      {
+        rq = -rs - rr;
+      }
+    else if (ds > dr)
+      {
+        rs = -rq - rr;
+      }
+    q = rq;
+    s = rs;
+  }
+
+  double CenterX (int q, int s) const
+  {
+    return width * (q + 0.5 * s);
+  }
+
+  double CenterY (int s) const
+  {
+    return rowHeight * s;
+  }
+
+  double radiusSquared, innerSquared, width, rowHeight;
+};
+
+// Axial offsets of the six neighbors of a hexagon
+static const int HEX_NEIGHBORS[6][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, -1}, {-1, 1}};
+
+/*
+ * A block of sites and their lattice cells, the cells computed together
+ * by the SIMD kernels.
+ */
+struct CellBlock
+{
+  static constexpr size_t SIZE = 256;
+
+  void ComputeCells (size_t count, const FastCoverLattice &L)
+  {
+    UdcSimd::Cells (x, count, L.gridWidth, vertical);
+    UdcSimd::Cells (y, count, L.gridWidth, horizontal);
+  }
+
+  double x[SIZE], y[SIZE];
+  int vertical[SIZE], horizontal[SIZE];
+};
+
+/*
+ * Outcome of testing one site against the lattice disks placed so far.
+ */
+enum CellDecision
+{
+  CELL_COVERED, // a disk already placed covers the site
+  CELL_INSERT,  // the site needs the disk of its own cell
+  CELL_UNKNOWN  // the outcome depends on a cell the caller cannot see yet
+};
+
+// Offsets of the four neighbors of a square lattice cell, in the order DecideCell tries them
+static const int CELL_NEIGHBORS[4][2] = {{1, 0}, {-1, 0}, {0, -1}, {0, 1}};
+
+/*
+ * The per-site test of the Ghosh et al. algorithm.  present(vertical,horizontal)
+ * returns 1 if the cell holds a disk, 0 if it does not, and -1 if the caller
+ * does not know yet (e.g. the cell lies across a tile seam).  On CELL_COVERED,
+ * the cell whose disk covers the site is packed into *cover, if given; that
+ * is the first of its own cell and CELL_NEIGHBORS holding a disk, so given
+ * cover, an unknown cell before it leaves the outcome unknown.
+ * The distances are taken by the Geometry policy, and counted in *tests,
+ * if given.
+ */
+template <typename Geometry, typename Presence>
+inline CellDecision
+DecideCell (double px, double py, const FastCoverLattice &L, int vertical, int horizontal, Presence present,
+            uint64_t *cover = nullptr, UdcCounter *tests = nullptr)
+{
+  const double verticalTimesGridWidth = vertical * L.gridWidth,
+               horizontalTimesGridWidth = horizontal * L.gridWidth;
+
+  const int own = present (vertical, horizontal);
+  if (own > 0 && cover)
+    {
+      *cover = LatticeCellTable::Pack (vertical, horizontal);
+    }
+  if (own != 0)
+    {
+      return own > 0 ? CELL_COVERED : CELL_UNKNOWN;
+    }
+
+  auto within = [&] (double x, double y) {
+    if (tests)
+      {
+        ++*tests;
+      }
+    return !(Geometry::SquaredDistance (px, py, x, y) > L.radiusSquared);
+  };
+
+  // A neighbor check only matters when its geometric part holds
+  const int neighbors[4] = {
+    px >= verticalTimesGridWidth + L.nextReach
+        && within (L.gridWidth * (vertical + 1) + L.additiveFactor, horizontalTimesGridWidth + L.additiveFactor)
+      ? present (vertical + 1, horizontal) : 0,
+    px <= verticalTimesGridWidth + L.previousReach
+        && within (L.gridWidth * (vertical - 1) + L.additiveFactor, horizontalTimesGridWidth + L.additiveFactor)
+      ? present (vertical - 1, horizontal) : 0,
+    py <= horizontalTimesGridWidth + L.previousReach
+        && within (verticalTimesGridWidth + L.additiveFactor, L.gridWidth * (horizontal - 1) + L.additiveFactor)
+      ? present (vertical, horizontal - 1) : 0,
+    py >= horizontalTimesGridWidth + L.nextReach
+        && within (verticalTimesGridWidth + L.additiveFactor, L.gridWidth * (horizontal + 1) + L.additiveFactor)
+      ? present (vertical, horizontal + 1) : 0
+  };
+
+  bool unknown = false;
+  for (int k = 0; k < 4; ++k)
+    {
+      if (neighbors[k] > 0)
+        {
+          if (unknown && cover)
+            {
+              // An earlier neighbor might hold the disk serial order picks
+              return CELL_UNKNOWN;
+            }
+          if (cover)
+            {
+              *cover = LatticeCellTable::Pack (vertical + CELL_NEIGHBORS[k][0], horizontal + CELL_NEIGHBORS[k][1]);
+            }
+          return CELL_COVERED;
+        }
+      unknown = unknown || neighbors[k] < 0;
+    }
+  return unknown ? CELL_UNKNOWN : CELL_INSERT;
+}
+
+/*
+ * The vertical chord a site leaves on the restriction line of its strip.
+ */
+struct StripInterval
+{
+  double top, bottom;
+  uint32_t site;
+};
+
+/*
+ * One pass of the Liu-Lu strip algorithm, with the strips shifted right by
+ * shift*sqrt(3)*radius/6.  The sites are pushed in order of x, and only
+ * the strip being filled is kept.  The chosen disk centers are passed to
+ * emit(x,y,first,last) a strip at a time, with the chords [first,last) of
+ * the sites each disk is chosen to cover.  The strips are placed in
+ * Geometry::Strip arithmetic.
+ */
+template <typename Geometry>
+class LLStripSweep
+{
+public:
+  LLStripSweep (double radius, unsigned shift)
+    : radius (radius),
+      shift (shift),
+      sqrt3TimesRadius (std::sqrt (3) * radius),
+      sqrt3TimesRadiusOver2 (sqrt3TimesRadius / 2)
+  {
+  }
+
+  template <typename Emit>
+  void Push (double x, double y, uint32_t site, Emit emit)
+  {
+    if (!started)
+      {
+        rightOfCurrentStrip = x + ((shift * sqrt3TimesRadius) / 6);
+        started = true;
+      }
+
+    for (;;)
+      {
+        if (filling)
+          {
+            if (x < rightOfCurrentStrip)
+              {
+                AddInterval (x, y, site);
+                return;
+              }
+            EmitStrip (emit);
+            continue;
+          }
+
+        if (x > rightOfCurrentStrip)
+          {
+            int jump = (x - rightOfCurrentStrip) / sqrt3TimesRadius;
+            rightOfCurrentStrip += jump * sqrt3TimesRadius;
+
+            if (jump > 0)
+              {
+                continue;
+              }
+          }
+
+        // The site opens the next strip, or that strip is empty
+        filling = true;
+        intervals.clear ();
+        xOfRestrictionline = rightOfCurrentStrip - sqrt3TimesRadiusOver2;
+        if (x >= rightOfCurrentStrip)
+          {
+            EmitStrip (emit);
+          }
+      }
+  }
+
+  template <typename Emit>
+  void Finish (Emit emit)
+  {
+    if (filling)
+      {
+        EmitStrip (emit);
+      }
+  }
+
+  // The number of strips emitted that held sites
+  UdcCounter GetStrips (void) const
+  {
+    return strips;
+  }
+
+  // The bytes of the chords of the strip being filled, as allocated
+  size_t GetHeldBytes (void) const
+  {
+    return intervals.capacity () * sizeof (StripInterval);
+  }
+
+private:
+  void AddInterval (double x, double y, uint32_t site)
+  {
+    const Strip distanceFromRestrictionLine = x - xOfRestrictionline;
+    const Strip chord = Geometry::Chord (radius, distanceFromRestrictionLine);
+    intervals.push_back ({double (y + chord), double (y - chord), site});
+  }
+
+  template <typename Emit>
+  void EmitStrip (Emit emit)
+  {
+    filling = false;
+    rightOfCurrentStrip += sqrt3TimesRadius;
+
+    if (intervals.size () == 0)
+      {
+        return;
+      }
+    ++strips;
+
+    sort (intervals.begin (), intervals.end (),
+          [] (const StripInterval &si, const StripInterval &sj) { return (si.bottom > sj.bottom); });
+
+    Strip lowestY = intervals[0].bottom;
+    const StripInterval *first = intervals.data ();
+
+    for (size_t k = 1; k < intervals.size (); ++k)
+      {
+        if (intervals[k].top < lowestY)
+          {
+            emit (double (xOfRestrictionline), double (lowestY), first, &intervals[k]);
+            lowestY = intervals[k].bottom;
+            first = &intervals[k];
+          }
+      }
+    emit (double (xOfRestrictionline), double (lowestY), first, intervals.data () + intervals.size ());
+  }
+
+  typedef typename Geometry::Strip Strip;
+
+  const double radius;
+  const unsigned shift;
+  const Strip sqrt3TimesRadius, sqrt3TimesRadiusOver2;
+  bool started = false;
+  bool filling = false; // a strip is open, bounded by rightOfCurrentStrip
+  Strip rightOfCurrentStrip = 0, xOfRestrictionline = 0;
+  std::vector<StripInterval> intervals; // reused by every strip
+  UdcCounter strips = 0;
+};
+
+/*
+ * One pass of the Liu-Lu strip algorithm over all of P, which must be
+ * sorted on x, passing the chosen disks to emit as LLStripSweep does, with
+ * the sites numbered by their index in P.  The pass gives up once stop()
+ * returns true.  Returns the number of strips that held sites.
+ */
+template <typename Geometry, typename Emit, typename Stop>
+UdcCounter
+LLShift (const UdcSiteStore &P, double radius, unsigned shift, Emit emit, Stop stop)
+{
+  LLStripSweep<Geometry> sweep (radius, shift);
+  for (size_t j = 0; j < P.GetN (); ++j)
+    {
+      if ((j & 4095) == 0 && stop ())
+        {
+          return sweep.GetStrips ();
+        }
+      sweep.Push (P.X (j), P.Y (j), j, emit);
+    }
+  sweep.Finish (emit);
+  return sweep.GetStrips ();
+}
+
+/*
+ * Whether a site at offset (dx,dy) from a disk center is inside the disk.
+ * The slack absorbs the rounding in centers computed from the sites.
+ */
+inline bool
+WithinRadius (double dx, double dy, double radiusSquared)
+{
+  return dx * dx + dy * dy <= radiusSquared * (1 + 1e-9);
+}
+
+/*
+ * A lattice disk placed while processing the site with the given index.
+ */
+struct CellBirth
+{
+  uint32_t site;
+  int vertical, horizontal;
+};
+
+/**
+ * \ingroup mobility
+ * \brief The unit disk cover algorithms, on their own.
+ *
+ * Nothing here depends on ns-3 or CGAL, so the algorithms can be built
+ * into a program of their own, such as udc-cover, which starts in
+ * milliseconds.  UDCPositionAllocator is a thin adapter over this class,
+ * adding the cache, the components, PORTFOLIO and the ns-3 attributes.
+ *
+ * A UdcCover covers the sites of a UdcSiteStore within the given bounds,
+ * which must contain every site, on the workers of a pool.  Run appends
+ * the disk centers to the caller's arrays, and, given a UdcAssignment
+ * already Reset to the number of sites, notes the disk of every site,
+ * numbering the disks by their index in those arrays.
+ */
+class UdcCover
+{
+public:
+  enum Algorithm
+  {
+    FAST_COVER = 0, //!< Ghosh et al, disks on a square lattice
+    SWEEP,          //!< Biniaz et al, a plane sweep
+    STRIPS,         //!< Liu-Lu, the best of six strip shifts
+    FAST_COVER_HEX  //!< Ghosh et al, disks on a hexagonal lattice
+  };
+  /**
+   * Active-set structures available to the SWEEP algorithm
+   */
+  enum SweepEngine
+  {
+    SWEEP_TREE = 0, //!< std::set of active disks ordered by y
+    SWEEP_BUCKETS   //!< flat arrays of active disks in bands of y
+  };
+
+  /**
+   * \param sites the sites to cover, which must outlive the UdcCover
+   * \param minX the least x of the sites, or less
+   * \param minY the least y of the sites, or less
+   * \param maxX the greatest x of the sites, or more
+   * \param maxY the greatest y of the sites, or more
+   * \param pool the workers to cover on
+   */
+  UdcCover (const UdcSiteStore &sites, double minX, double minY, double maxX, double maxY, UdcThreadPool &pool)
+    : m_sites (sites),
+      m_minX (minX),
+      m_minY (minY),
+      m_maxX (maxX),
+      m_maxY (maxY),
+      m_pool (pool)
+  {
+  }
+
+  /**
+   * \brief Use sites already sorted on x for SWEEP and STRIPS, instead of
+   * sorting them on first use
+   * \param sorted the sites sorted on x
+   * \param order the index of each sorted site among the sites, needed
+   *        to record an assignment
+   */
+  void SetSortedSites (const UdcSiteStore &sorted, const std::vector<uint32_t> *order)
+  {
+    m_sorted = &sorted;
+    m_order = order;
+  }
+
+  void SetSweepEngine (SweepEngine engine)
+  {
+    m_sweepEngine = engine;
+  }
+
+  /**
+   * \brief Run FAST_COVER on several workers only with at least the given
+   * number of sites in each band, see ParallelFastCover
+   */
+  void SetMinBandSites (uint64_t sites)
+  {
+    m_minBandSites = sites;
+  }
+
+  /**
+   * \brief Give up once stop () returns true, which the algorithms ask
+   * every few thousand sites, from any of the workers.  FAST_COVER on
+   * more than one worker never gives up.
+   */
+  void SetStop (std::function<bool (void)> stop)
+  {
+    m_stop = std::move (stop);
+  }
+
+  /**
+   * \brief Note the disk of every site in assignment, or nothing if null
+   */
+  void SetAssignment (UdcAssignment *assignment)
+  {
+    m_assignment = assignment;
+  }
+
+  /**
+   * \brief Add the times and counts of every Run to stats, or to nothing
+   * if null; see UdcCoverStats
+   */
+  void SetStats (UdcCoverStats *stats)
+  {
+    m_stats = stats;
+  }
+
+  /**
+   * \brief Cover the sites with disks of the given radius
+   *
+   * Geometry is the policy the distances are taken in, see udc-geometry.h;
+   * each policy compiles into variants of the algorithms of their own.
+   * The bucketed SWEEP engine tests distances in its own SIMD kernels,
+   * whatever the policy.
+   *
+   * \param x where the x of the disk centers are appended
+   * \param y where the y of the disk centers are appended
+   * \return false if the algorithm gave up, leaving part of a cover
+   */
+  template <typename Geometry = UdcDoubleGeometry>
+  bool Run (Algorithm algorithm, double radius, std::vector<double> &x, std::vector<double> &y)
+  {
+    m_x = &x;
+    m_y = &y;
+    m_stopped = false;
+    const uint32_t firstDisk = GetNDisks ();
+    const double nested = NestedSeconds ();
+    {
+      UdcPhaseTimer timer (m_stats, UdcCoverStats::COVER);
+      Dispatch<Geometry> (algorithm, radius);
+    }
+    if (m_stats)
+      {
+        // The sort and the assignment are timed as phases of their own
+        m_stats->seconds[UdcCoverStats::COVER] -= NestedSeconds () - nested;
+      }
+    Count (&UdcCoverStats::disks, GetNDisks () - firstDisk);
+    return !m_stopped;
+  }
+
+private:
+  /**
+   * \brief Run an algorithm on the workers of the pool
+   */
+  template <typename Geometry>
+  void Dispatch (Algorithm algorithm, double radius)
+  {
+    switch (algorithm)
+      {
+      case SWEEP:
+        BLMS<Geometry> (radius);
+        break;
+      case STRIPS:
+        LL<Geometry> (radius);
+        break;
+      case FAST_COVER_HEX:
+        HexFastCover<Geometry> (radius);
+        break;
+      case FAST_COVER:
+      default:
+        // The tiling and the serial replay of the seams take about three
+        // times the work of the serial sweep, which only pays with many
+        // workers and bands large enough to spread it over
+        if (m_pool.GetN () == 1 || m_sites.GetN () / 2 < m_minBandSites)
+          {
+            FastCover<Geometry> (radius);
+          }
+        else
+          {
+            ParallelFastCover<Geometry> (radius);
+          }
+      }
+  }
+
+  /**
+   * \brief Perform the Ghosh et al algorithm on the sites in input order
+   */
+  template <typename Geometry>
+  void FastCover (double radius);
+
+  /**
+   * \brief Perform the Ghosh et al algorithm on lattice-aligned tiles in parallel
+   *
+   * Produces exactly the disks of FastCover, in the same order.  Each band
+   * holds at least SetMinBandSites sites, so there may be fewer bands
+   * than workers.
+   */
+  template <typename Geometry>
+  void ParallelFastCover (double radius);
+
+  /**
+   * \brief Perform the Ghosh et al algorithm on a hexagonal lattice
+   *
+   * The hexagons have the radius as circumradius, so they tile the plane
+   * with about 23% fewer disks than the squares of FastCover.
+   */
+  template <typename Geometry>
+  void HexFastCover (double radius);
+
+  /**
+   * \brief Perform the Biniaz et al algorithm on the sites sorted on x
+   */
+  template <typename Geometry>
+  void BLMS (double radius);
+
+  /**
+   * \brief Perform the Liu-Lu algorithm on the sites sorted on x
+   */
+  template <typename Geometry>
+  void LL (double radius);
+
+  /**
+   * \brief Assign each site to the disk of the lattice cell that covers it
+   *
+   * \param siteCell the packed cell covering each site, see LatticeCellTable::Pack
+   * \param diskCell the packed cell of each of the last diskCell.size ()
+   *        disks placed
+   */
+  void AssignByCell (const std::vector<uint64_t> &siteCell, const std::vector<uint64_t> &diskCell);
+
+  /**
+   * \brief Append a disk center to the cover
+   */
+  void Place (double x, double y)
+  {
+    m_x->push_back (x);
+    m_y->push_back (y);
+  }
+
+  /**
+   * \return the number of disks placed, which is the index of the next
+   */
+  uint32_t GetNDisks (void) const
+  {
+    return m_x->size ();
+  }
+
+  /**
+   * \brief Add a count to a counter of the stats, if kept
+   */
+  void Count (uint64_t UdcCoverStats::*counter, UdcCounter count)
+  {
+    if (m_stats)
+      {
+        m_stats->*counter += count;
+      }
+  }
+
+  /**
+   * \brief Note in the stats, if kept, a working set of the given bytes
+   * besides the sites, the sorted sites and the disks
+   */
+  void NoteBytes (size_t bytes)
+  {
+    if (m_stats)
+      {
+        if (m_sorted)
+          {
+            bytes += m_sorted->GetBytes () + (m_order ? m_order->capacity () * sizeof (uint32_t) : 0);
+          }
+        m_stats->NoteBytes (m_sites.GetBytes () + (m_x->capacity () + m_y->capacity ()) * sizeof (double)
+                            + bytes);
+      }
+  }
+
+  /**
+   * \return the seconds of the phases timed within COVER
+   */
+  double NestedSeconds (void) const
+  {
+    return m_stats ? m_stats->seconds[UdcCoverStats::SORT] + m_stats->seconds[UdcCoverStats::ASSIGN] : 0;
+  }
+
+  /**
+   * \return true, from then on, once the stop function has returned true
+   */
+  bool Stopped (void)
+  {
+    if (!m_stopped && m_stop && m_stop ())
+      {
+        m_stopped = true;
+      }
+    return m_stopped;
+  }
+
+  /**
+   * \return the sites sorted on x, given or sorted on first use
+   */
+  const UdcSiteStore &Sorted (void)
+  {
+    if (!m_sorted || (m_assignment && !m_order))
+      {
+        UdcPhaseTimer timer (m_stats, UdcCoverStats::SORT);
+        std::vector<uint32_t> order (m_sites.GetN ());
+        for (uint32_t i = 0; i < order.size (); ++i)
+          {
+            order[i] = i;
+          }
+        ParallelRadixSort (order, [this] (uint32_t i) { return m_sites.X (i); }, m_pool);
+        m_ownSorted.Gather (m_sites, order, m_pool);
+        m_ownOrder = std::move (order);
+        m_sorted = &m_ownSorted;
+        m_order = &m_ownOrder;
+      }
+    return *m_sorted;
+  }
+
+  const UdcSiteStore &m_sites; //!< sites to cover
+  const double m_minX, m_minY, m_maxX, m_maxY; //!< bounds of the sites
+  UdcThreadPool &m_pool; //!< workers
+  SweepEngine m_sweepEngine = SWEEP_TREE; //!< active-set structure used by BLMS
+  uint64_t m_minBandSites = uint64_t (1) << 20; //!< fewest sites in a band of ParallelFastCover
+  std::function<bool (void)> m_stop; //!< asked whether to give up, if set
+  std::atomic<bool> m_stopped {false}; //!< the last Run gave up
+  UdcAssignment *m_assignment = nullptr; //!< where the disk of each site goes, if set
+  UdcCoverStats *m_stats = nullptr; //!< where the times and counts go, if set
+  const UdcSiteStore *m_sorted = nullptr; //!< the sites sorted on x, null until needed
+  const std::vector<uint32_t> *m_order = nullptr; //!< the index in m_sites of each of *m_sorted
+  UdcSiteStore m_ownSorted; //!< the sites sorted here, if not given
+  std::vector<uint32_t> m_ownOrder; //!< the order of m_ownSorted
+  std::vector<double> *m_x = nullptr; //!< where Run puts the x of the disks
+  std::vector<double> *m_y = nullptr; //!< where Run puts the y of the disks
+};
+
+inline void
+UdcCover::AssignByCell (const std::vector<uint64_t> &siteCell, const std::vector<uint64_t> &diskCell)
+{
+  UdcPhaseTimer timer (m_stats, UdcCoverStats::ASSIGN);
+  // Every cell holds one disk at most, so the disks sorted by cell can be searched
+  const uint32_t firstDisk = GetNDisks () - diskCell.size ();
+  std::vector<std::pair<uint64_t, uint32_t>> disks (diskCell.size ());
+  for (uint32_t d = 0; d < diskCell.size (); ++d)
+    {
+      disks[d] = std::make_pair (diskCell[d], firstDisk + d);
+    }
+  std::sort (disks.begin (), disks.end ());
+
+  UdcThreadPool &pool = m_pool;
+  const size_t n = siteCell.size ();
+  const size_t chunks = std::min<size_t> (pool.GetN () * 4, (n + 65535) / 65536);
+  pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+    for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i)
+      {
+        const auto disk = std::lower_bound (disks.begin (), disks.end (), std::make_pair (siteCell[i], uint32_t (0)));
+        m_assignment->Assign (i, disk->second);
+      }
+  });
+}
+
+template<typename Geometry>
+inline void
+UdcCover::FastCover (double radius) {
+	/*
+	 * Code and algorithm from
+	 *
+	 * Ghosh, A., Hicks, B., Shevchenko, R. (2017):
+	 * Unit Disk Cover for Massive Point Sets.
+	 * In: Kotsireas I., Pardalos P., Parsopoulos
+	 * K., Souravlias D., Tsokas A. (eds) Analysis
+	 * of Experimental Algorithms. SEA 2019.
+	 * Lecture Notes in Computer Science, vol
+	 * 11544. Springer, Cham.
+	 * https://doi.org/10.1007/978-3-030-34029-2_10.
+	 */
+    const FastCoverLattice lattice (radius);
+    LatticeCellTable hashTableForLatticeDiskCenters;
+    hashTableForLatticeDiskCenters.Reserve( m_sites.GetN(),
+    		lattice.Cell(m_minX), lattice.Cell(m_maxX),
+    		lattice.Cell(m_minY), lattice.Cell(m_maxY) );
+
+    UdcCounter probes = 0, tests = 0;
+    auto present = [&]( int vertical, int horizontal ) {
+    	++probes;
+    	return int(hashTableForLatticeDiskCenters.Contains( vertical, horizontal ));
+    };
+
+    // The cell of the disk covering each site, and the cell of each disk
+    std::vector<uint64_t> siteCell( m_assignment ? m_sites.GetN() : 0 ), diskCell;
+
+    CellBlock block;
+    for( size_t first = 0; first < m_sites.GetN(); first += CellBlock::SIZE ) {
+        if( Stopped() )
+            return;
+        const size_t count = std::min( CellBlock::SIZE, m_sites.GetN() - first );
+        m_sites.Decode( first, count, block.x, block.y );
+        block.ComputeCells( count, lattice );
+
+        for( size_t k = 0; k < count; k++ ) {
+            const double x = block.x[k], y = block.y[k];
+            int vertical = block.vertical[k];
+            int horizontal = block.horizontal[k];
+
+            uint64_t* cover = m_assignment ? &siteCell[first+k] : nullptr;
+            if( DecideCell<Geometry>( x, y, lattice, vertical, horizontal, present, cover, &tests ) == CELL_COVERED )
+                continue;
+
+            hashTableForLatticeDiskCenters.Insert( vertical, horizontal );
+            Place( vertical*lattice.gridWidth+lattice.additiveFactor,
+                   horizontal*lattice.gridWidth+lattice.additiveFactor );
+            if( cover ) {
+                *cover = LatticeCellTable::Pack( vertical, horizontal );
+                diskCell.push_back( *cover );
+            }
+        }
+    }
+    Count( &UdcCoverStats::cellProbes, probes );
+    Count( &UdcCoverStats::cellInserts, hashTableForLatticeDiskCenters.GetSize() );
+    Count( &UdcCoverStats::coverageTests, tests );
+    NoteBytes( hashTableForLatticeDiskCenters.GetBytes()
+               + (siteCell.capacity() + diskCell.capacity()) * sizeof(uint64_t) );
+    if( m_assignment )
+        AssignByCell( siteCell, diskCell );
+}
+
+template <typename Geometry>
+inline void
+UdcCover::ParallelFastCover (double radius)
+{
+  /*
+   * Tiled version of FastCover.  The lattice columns spanned by m_bounds
+   * are cut into bands holding roughly equal numbers of sites, and each
+   * band is swept on its own worker in input order.  A site whose test
+   * needs a cell of another band, or a cell that was itself deferred,
+   * is deferred along with every later site of its own cell.  Deferred
+   * sites are then replayed serially in input order, treating a cell as
+   * present for site i only if its disk was born at a site before i.
+   * This reproduces the serial decisions, and the disks are emitted in
+   * serial order by merging the bands on their birth index.
+   */
+  const size_t n = m_sites.GetN ();
+  if (n == 0)
+    {
+      return;
+    }
+
+  UdcThreadPool &pool = m_pool;
+  const FastCoverLattice lattice (radius);
+
+  // Group the lattice columns into coarse buckets and count the sites in each
+  const long long firstColumn = lattice.Cell (m_minX), lastColumn = lattice.Cell (m_maxX);
+  const size_t columns = lastColumn - firstColumn + 1, nBuckets = std::min<size_t> (columns, 4096),
+               columnsPerBucket = (columns + nBuckets - 1) / nBuckets;
+
+  auto bucketOfColumn = [&] (long long column) {
+    return std::min<size_t> (std::max<long long> (column - firstColumn, 0) / columnsPerBucket, nBuckets - 1);
+  };
+
+  const size_t nChunks = pool.GetN ();
+  auto chunkBegin = [&] (size_t c) { return n * c / nChunks; };
+
+  // The column of every site, reused by the counting, the scatter and the sweep
+  std::vector<int> columnOfSite (n);
+  std::vector<std::vector<size_t>> chunkCounts (nChunks, std::vector<size_t> (nBuckets, 0));
+  pool.ParallelFor (nChunks, [&] (size_t c, unsigned) {
+    CellBlock block;
+    for (size_t first = chunkBegin (c); first < chunkBegin (c + 1); first += CellBlock::SIZE)
+      {
+        const size_t count = std::min (CellBlock::SIZE, chunkBegin (c + 1) - first);
+        m_sites.Decode (first, count, block.x, block.y);
+        UdcSimd::Cells (block.x, count, lattice.gridWidth, &columnOfSite[first]);
+      }
+    for (size_t i = chunkBegin (c); i < chunkBegin (c + 1); ++i)
+      {
+        ++chunkCounts[c][bucketOfColumn (columnOfSite[i])];
+      }
+  });
+
+  // Cut the buckets into bands of roughly n/nTiles sites each
+  std::vector<size_t> bucketTotals (nBuckets, 0);
+  for (const auto &counts : chunkCounts)
+    {
+      for (size_t b = 0; b < nBuckets; ++b)
+        {
+          bucketTotals[b] += counts[b];
+        }
+    }
+
+  const size_t nTiles = std::min<size_t> (std::min<size_t> (nBuckets, pool.GetN ()),
+                                          std::max<uint64_t> (n / std::max<uint64_t> (m_minBandSites, 1), 1));
+  std::vector<size_t> tileOfBucket (nBuckets);
+  size_t tile = 0, running = 0;
+  for (size_t b = 0; b < nBuckets; ++b)
+    {
+      tileOfBucket[b] = tile;
+      running += bucketTotals[b];
+      if (running * nTiles >= (tile + 1) * n && tile + 1 < nTiles)
+        {
+          ++tile;
+        }
+    }
+  const size_t usedTiles = tileOfBucket.back () + 1;
+
+  std::vector<size_t> tileFirstBucket (usedTiles, nBuckets), tileLastBucket (usedTiles, 0);
+  for (size_t b = 0; b < nBuckets; ++b)
+    {
+      tileFirstBucket[tileOfBucket[b]] = std::min (tileFirstBucket[tileOfBucket[b]], b);
+      tileLastBucket[tileOfBucket[b]] = b;
+    }
+
+  // Scatter site indices by band, keeping input order within each band
+  std::vector<size_t> tileBegin (usedTiles + 1);
+  std::vector<std::vector<size_t>> chunkOffsets (nChunks, std::vector<size_t> (usedTiles, 0));
+  for (size_t c = 0; c < nChunks; ++c)
+    {
+      for (size_t b = 0; b < nBuckets; ++b)
+        {
+          chunkOffsets[c][tileOfBucket[b]] += chunkCounts[c][b];
+        }
+    }
+  size_t offset = 0;
+  for (size_t t = 0; t < usedTiles; ++t)
+    {
+      tileBegin[t] = offset;
+      for (size_t c = 0; c < nChunks; ++c)
+        {
+          size_t count = chunkOffsets[c][t];
+          chunkOffsets[c][t] = offset;
+          offset += count;
+        }
+    }
+  tileBegin[usedTiles] = n;
+
+  std::vector<uint32_t> order (n);
+  pool.ParallelFor (nChunks, [&] (size_t c, unsigned) {
+    std::vector<size_t> &next = chunkOffsets[c];
+    for (size_t i = chunkBegin (c); i < chunkBegin (c + 1); ++i)
+      {
+        order[next[tileOfBucket[bucketOfColumn (columnOfSite[i])]]++] = i;
+      }
+  });
+
+  // Sweep every band on its own
+  std::vector<std::vector<CellBirth>> births (usedTiles);
+  std::vector<std::vector<uint32_t>> deferred (usedTiles);
+  // The cell of the disk covering each site, written by the band or the replay deciding it
+  std::vector<uint64_t> siteCell (m_assignment ? n : 0);
+  // The counts of each band, and the bytes of its tables
+  std::vector<UdcCounter> tileProbes (usedTiles), tileTests (usedTiles);
+  std::vector<size_t> tileBytes (usedTiles);
+
+  pool.ParallelFor (usedTiles, [&] (size_t t, unsigned) {
+    LatticeCellTable occupied, deferredCells;
+    UdcCounter probes = 0, tests = 0;
+    occupied.Reserve (tileBegin[t + 1] - tileBegin[t], firstColumn + tileFirstBucket[t] * columnsPerBucket,
+                      firstColumn + (tileLastBucket[t] + 1) * columnsPerBucket - 1, lattice.Cell (m_minY),
+                      lattice.Cell (m_maxY));
+
+    auto present = [&] (int vertical, int horizontal) {
+      ++probes;
+      if (occupied.Contains (vertical, horizontal))
+        {
+          return 1;
+        }
+      if (tileOfBucket[bucketOfColumn (vertical)] != t || deferredCells.Contains (vertical, horizontal))
+        {
+          return -1;
+        }
+      return 0;
+    };
+
+    CellBlock block;
+    for (size_t first = tileBegin[t]; first < tileBegin[t + 1]; first += CellBlock::SIZE)
+      {
+        const size_t count = std::min (CellBlock::SIZE, tileBegin[t + 1] - first);
+        for (size_t k = 0; k < count; ++k)
+          {
+            block.x[k] = m_sites.X (order[first + k]);
+            block.y[k] = m_sites.Y (order[first + k]);
+          }
+        UdcSimd::Cells (block.y, count, lattice.gridWidth, block.horizontal);
+
+        for (size_t k = 0; k < count; ++k)
+          {
+            const uint32_t i = order[first + k];
+            const double x = block.x[k], y = block.y[k];
+            int vertical = columnOfSite[i];
+            int horizontal = block.horizontal[k];
+
+            if (deferredCells.Contains (vertical, horizontal))
+              {
+                deferred[t].push_back (i);
+                continue;
+              }
+
+            uint64_t *cover = m_assignment ? &siteCell[i] : nullptr;
+            switch (DecideCell<Geometry> (x, y, lattice, vertical, horizontal, present, cover, &tests))
+              {
+              case CELL_COVERED:
+                break;
+              case CELL_UNKNOWN:
+                deferredCells.Insert (vertical, horizontal);
+                deferred[t].push_back (i);
+                break;
+              case CELL_INSERT:
+                occupied.Insert (vertical, horizontal);
+                births[t].push_back ({i, vertical, horizontal});
+                if (cover)
+                  {
+                    *cover = LatticeCellTable::Pack (vertical, horizontal);
+                  }
+                break;
+              }
+          }
+      }
+    tileProbes[t] = probes;
+    tileTests[t] = tests;
+    tileBytes[t] = occupied.GetBytes () + deferredCells.GetBytes ();
+  });
+  UdcCounter probes = 0, tests = 0;
+  size_t bytes = 0;
+  for (size_t t = 0; t < usedTiles; ++t)
+    {
+      probes += tileProbes[t];
+      tests += tileTests[t];
+      bytes += tileBytes[t] + births[t].capacity () * sizeof (CellBirth) + deferred[t].capacity () * sizeof (uint32_t);
+    }
+
+  // Replay the deferred sites in input order against the birth of every cell
+  std::vector<uint32_t> replay;
+  for (const auto &d : deferred)
+    {
+      replay.insert (replay.end (), d.begin (), d.end ());
+    }
+
+  if (!replay.empty ())
+    {
+      std::sort (replay.begin (), replay.end ());
+
+      // Only the cells of the deferred sites and their neighbors are looked up
+      LatticeCellTable looked;
+      for (uint32_t i : replay)
+        {
+          const int vertical = lattice.Cell (m_sites.X (i)), horizontal = lattice.Cell (m_sites.Y (i));
+          looked.Insert (vertical, horizontal);
+          for (const auto &n : CELL_NEIGHBORS)
+            {
+              looked.Insert (vertical + n[0], horizontal + n[1]);
+            }
+        }
+      std::unordered_map<uint64_t, uint32_t> birthOf;
+      for (const auto &tileBirths : births)
+        {
+          for (const CellBirth &b : tileBirths)
+            {
+              if (looked.Contains (b.vertical, b.horizontal))
+                {
+                  birthOf.emplace (LatticeCellTable::Pack (b.vertical, b.horizontal), b.site);
+                }
+            }
+        }
+
+      births.emplace_back ();
+      for (uint32_t i : replay)
+        {
+          const double x = m_sites.X (i), y = m_sites.Y (i);
+          int vertical = lattice.Cell (x);
+          int horizontal = lattice.Cell (y);
+
+          auto present = [&] (int v, int h) {
+            ++probes;
+            auto it = birthOf.find (LatticeCellTable::Pack (v, h));
+            return int (it != birthOf.end () && it->second < i);
+          };
+
+          uint64_t *cover = m_assignment ? &siteCell[i] : nullptr;
+          if (DecideCell<Geometry> (x, y, lattice, vertical, horizontal, present, cover, &tests) == CELL_INSERT)
+            {
+              birthOf.emplace (LatticeCellTable::Pack (vertical, horizontal), i);
+              births.back ().push_back ({i, vertical, horizontal});
+              if (cover)
+                {
+                  *cover = LatticeCellTable::Pack (vertical, horizontal);
+                }
+            }
+        }
+      // A node of the map holds about a key, a value and two pointers
+      bytes += replay.capacity () * sizeof (uint32_t) + looked.GetBytes () + birthOf.size () * (4 * sizeof (uint64_t));
+    }
+  Count (&UdcCoverStats::cellProbes, probes);
+  Count (&UdcCoverStats::coverageTests, tests);
+  Count (&UdcCoverStats::deferred, replay.size ());
+  NoteBytes (bytes + columnOfSite.capacity () * sizeof (int) + order.capacity () * sizeof (uint32_t)
+             + siteCell.capacity () * sizeof (uint64_t));
+
+  // Merge the bands on birth index so the disks come out in serial order
+  typedef std::pair<uint32_t, size_t> Head; // (site, band)
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+  std::vector<size_t> cursor (births.size (), 0);
+  for (size_t t = 0; t < births.size (); ++t)
+    {
+      if (!births[t].empty ())
+        {
+          heads.emplace (births[t][0].site, t);
+        }
+    }
+  for (const auto &tileBirths : births)
+    {
+      Count (&UdcCoverStats::cellInserts, tileBirths.size ());
+    }
+
+  std::vector<uint64_t> diskCell;
+  while (!heads.empty ())
+    {
+      const size_t t = heads.top ().second;
+      heads.pop ();
+      const CellBirth &b = births[t][cursor[t]++];
+      Place (b.vertical * lattice.gridWidth + lattice.additiveFactor,
+             b.horizontal * lattice.gridWidth + lattice.additiveFactor);
+      if (m_assignment)
+        {
+          diskCell.push_back (LatticeCellTable::Pack (b.vertical, b.horizontal));
+        }
+      if (cursor[t] < births[t].size ())
+        {
+          heads.emplace (births[t][cursor[t]].site, t);
+        }
+    }
+  if (m_assignment)
+    {
+      AssignByCell (siteCell, diskCell);
+    }
+}
+
+template <typename Geometry>
+inline void
+UdcCover::HexFastCover (double radius)
+{
+  /*
+   * FastCover with hexagonal cells.  Each site falls in one hexagon, and
+   * the disk circumscribing that hexagon covers it.  As in FastCover, a
+   * site needs no disk if its own hexagon has one, or if the disk of a
+   * neighboring hexagon reaches it; the distance to a neighbor is tested
+   * before its cell is looked up, so most sites only probe their own.
+   */
+  const HexLattice lattice (radius);
+
+  // The hexagons spanned by the corners of the bounds, and their neighbors
+  int minQ = INT_MAX, maxQ = INT_MIN, minS = INT_MAX, maxS = INT_MIN;
+  for (const double x : {m_minX, m_maxX})
+    {
+      for (const double y : {m_minY, m_maxY})
+        {
+          int q, s;
+          lattice.Cell (x, y, q, s);
+          minQ = std::min (minQ, q - 1);
+          maxQ = std::max (maxQ, q + 1);
+          minS = std::min (minS, s - 1);
+          maxS = std::max (maxS, s + 1);
+        }
+    }
+  LatticeCellTable centers;
+  centers.Reserve (m_sites.GetN (), minQ, maxQ, minS, maxS);
+
+  // The hexagon of the disk covering each site, and the hexagon of each disk
+  std::vector<uint64_t> siteCell (m_assignment ? m_sites.GetN () : 0), diskCell;
+  UdcCounter probes = 0, tests = 0;
+
+  for (size_t i = 0; i < m_sites.GetN (); ++i)
+    {
+      if ((i & 4095) == 0 && Stopped ())
+        {
+          return;
+        }
+      const double x = m_sites.X (i), y = m_sites.Y (i);
+      int q, s;
+      lattice.Cell (x, y, q, s);
+      if (m_assignment)
+        {
+          siteCell[i] = LatticeCellTable::Pack (q, s);
+        }
+      ++probes;
+      if (centers.Contains (q, s))
+        {
+          continue;
+        }
+
+      // A neighbor's disk only reaches sites (sqrt(3)-1)*radius or more from the center
+      const double cx = x - lattice.CenterX (q, s), cy = y - lattice.CenterY (s);
+      bool covered = false;
+      for (const auto &n : HEX_NEIGHBORS)
+        {
+          if (cx * cx + cy * cy < lattice.innerSquared)
+            {
+              break;
+            }
+          ++tests;
+          if (!(Geometry::SquaredDistance (x, y, lattice.CenterX (q + n[0], s + n[1]), lattice.CenterY (s + n[1]))
+                > lattice.radiusSquared)
+              && (++probes, centers.Contains (q + n[0], s + n[1])))
+            {
+              covered = true;
+              if (m_assignment)
+                {
+                  siteCell[i] = LatticeCellTable::Pack (q + n[0], s + n[1]);
+                }
+              break;
+            }
+        }
+      if (covered)
+        {
+          continue;
+        }
+
+      centers.Insert (q, s);
+      Place (lattice.CenterX (q, s), lattice.CenterY (s));
+      if (m_assignment)
+        {
+          diskCell.push_back (siteCell[i]);
+        }
+    }
+  Count (&UdcCoverStats::cellProbes, probes);
+  Count (&UdcCoverStats::cellInserts, centers.GetSize ());
+  Count (&UdcCoverStats::coverageTests, tests);
+  NoteBytes (centers.GetBytes () + (siteCell.capacity () + diskCell.capacity ()) * sizeof (uint64_t));
+  if (m_assignment)
+    {
+      AssignByCell (siteCell, diskCell);
+    }
+}
+
+template<typename Geometry>
+inline void
+UdcCover::BLMS (double radius) {
+	/*
+	 * Algorithm from
+	 *
+	 * Biniaz, A., Liu, P., Maheshwari, A., Smid, M.:
+	 * Approximation algorithms for the unit disk cover
+	 * problem in 2D and 3D. Comput. Geom. 60, 8–18 (2017).
+	 *
+	 * Code adapted from
+	 *
+	 * Ghosh, A., Hicks, B., Shevchenko, R. (2017):
+	 * Unit Disk Cover for Massive Point Sets.
+	 * In: Kotsireas I., Pardalos P., Parsopoulos
+	 * K., Souravlias D., Tsokas A. (eds) Analysis
+	 * of Experimental Algorithms. SEA 2019.
+	 * Lecture Notes in Computer Science, vol
+	 * 11544. Springer, Cham.
+	 * https://doi.org/10.1007/978-3-030-34029-2_10.
+	 */
+
+	const double radius_squared = pow( radius, 2 );
+
+	// All points sorted on x-coordinate
+	const UdcSiteStore& P = Sorted ();
+	const uint32_t firstDisk = GetNDisks();
+
+	if( m_sweepEngine == SWEEP_BUCKETS ) {
+		// Same sweep, with the active disks in y bands instead of a BST
+		YBucketActiveSet active( m_minY, m_maxY, radius, P.GetN() );
+		for( size_t s = 0; s < P.GetN(); s++ ) {
+			if( (s & 4095) == 0 && Stopped() )
+				return;
+			const double x = P.X(s), y = P.Y(s);
+			const int64_t covering = active.Covering( x, y );
+			if( m_assignment )
+				m_assignment->Assign( (*m_order)[s], covering < 0 ? GetNDisks() : firstDisk + covering );
+			if( covering < 0 ) {
+				Place( x, y );
+				active.Insert( x, y );
+			}
+		}
+		Count( &UdcCoverStats::activeInserts, GetNDisks() - firstDisk );
+		NoteBytes( active.GetBytes() );
+		return;
+	}
+
+	// Create the BST of indices into P, ties on y broken by index so that
+	// disks at the same y are all kept, and erasing an index that is not a
+	// disk erases nothing
+	auto YSorter = [&P]( size_t lhs, size_t rhs ) {
+		return P.Y(lhs) < P.Y(rhs) || (P.Y(lhs) == P.Y(rhs) && lhs < rhs);
+	};
+    std::set<size_t,decltype(YSorter)> BST(YSorter); // the binary tree of y-sorted disks
+
+    // Predicate to tell if a point is covered by a disk
+	UdcCounter tests = 0, erases = 0;
+	size_t peak = 0;
+	auto isCovered = [&]( size_t p, size_t q ) {
+		++tests;
+		return Geometry::SquaredDistance( P.X(p), P.Y(p), P.X(q), P.Y(q) ) < radius_squared;
+	};
+
+	// The sites the disks are centered at, in order, to number the disks
+	std::vector<size_t> diskSites;
+
+	for( size_t sit = 0, dit = 0; sit < P.GetN(); sit++ ) {
+		if( (sit & 4095) == 0 && Stopped() )
+			return;
+		// Handle deletions
+		while( P.X(dit) + radius < P.X(sit) ) {
+			erases += BST.erase(dit);
+			dit++;
+		}
+
+		// Handle site
+		auto p_plus = BST.lower_bound(sit),
+			 pos(p_plus); // one higher than the site (p+)
+
+		bool siteIsCovered = false;
+		size_t coveredBy = 0;
+
+		while( pos != BST.end() && P.Y(*pos) - P.Y(sit) < radius && !siteIsCovered ) {
+			siteIsCovered = isCovered( sit, *pos );
+			coveredBy = *pos;
+			pos++;
+		}
+		pos = p_plus;
+
+		while( !siteIsCovered && pos != BST.begin() && P.Y(sit) - P.Y(*--pos) < radius ) {
+			siteIsCovered = isCovered( sit, *pos );
+			coveredBy = *pos;
+		}
+
+		if( m_assignment ) {
+			if( siteIsCovered )
+				m_assignment->Assign( (*m_order)[sit], firstDisk
+					+ (std::lower_bound( diskSites.begin(), diskSites.end(), coveredBy ) - diskSites.begin()) );
+			else {
+				m_assignment->Assign( (*m_order)[sit], GetNDisks() );
+				diskSites.push_back( sit );
+			}
+		}
+
+		if( !siteIsCovered ) {
+			// add disk centers to C
+			Place( P.X(sit), P.Y(sit) );
+			BST.insert(sit); // insert the Point into the BST
+			peak = std::max( peak, BST.size() );
+		}
+
+	}
+	Count( &UdcCoverStats::coverageTests, tests );
+	Count( &UdcCoverStats::activeInserts, GetNDisks() - firstDisk );
+	Count( &UdcCoverStats::activeErases, erases );
+	// A node of the tree holds a color, three pointers and the index
+	NoteBytes( peak * (4 * sizeof(void*) + sizeof(size_t)) + diskSites.capacity() * sizeof(size_t) );
+}
+
+template<typename Geometry>
+inline void
+UdcCover::LL (double radius) {
+	/*
+	 * Algorithm from
+	 *
+	 * Liu, P., Lu, D.: A fast 25/6-approximation for the
+	 * minimum unit disk cover problem. arXiv preprint
+	 * arXiv:1406.3838 (2014).
+	 *
+	 * Code adapted from
+	 *
+	 * Ghosh, A., Hicks, B., Shevchenko, R. (2017):
+	 * Unit Disk Cover for Massive Point Sets.
+	 * In: Kotsireas I., Pardalos P., Parsopoulos
+	 * K., Souravlias D., Tsokas A. (eds) Analysis
+	 * of Experimental Algorithms. SEA 2019.
+	 * Lecture Notes in Computer Science, vol
+	 * 11544. Springer, Cham.
+	 * https://doi.org/10.1007/978-3-030-34029-2_10.
+	 */
+
+	typedef std::vector<std::pair<double, double>> PointContainer;
+
+	// All points sorted on x-coordinate
+	const UdcSiteStore& P = Sorted ();
+	if( P.IsEmpty() )
+		return;
+
+	// The six shifted strip partitions are independent; keep the first smallest
+	PointContainer shiftCenters[6];
+	UdcCounter shiftStrips[6];
+	m_pool.ParallelFor( 6, [&]( size_t i, unsigned ) {
+		PointContainer& C = shiftCenters[i];
+		shiftStrips[i] = LLShift<Geometry>( P, radius, i, [&C]( double x, double y, const StripInterval*, const StripInterval* ) {
+			C.emplace_back(x,y);
+		}, [this]() { return Stopped(); } );
+	});
+	if( m_stopped )
+		return;
+
+	size_t bytes = 0;
+	for( size_t i = 0; i < 6; i++ ) {
+		if( m_stats )
+			m_stats->strips[i] += shiftStrips[i];
+		bytes += shiftCenters[i].capacity() * sizeof(std::pair<double, double>);
+	}
+	NoteBytes( bytes );
+
+	const PointContainer* C = &shiftCenters[0];
+	for( const PointContainer& tempC : shiftCenters )
+		if( tempC.size() < C->size() )
+			C = &tempC;
+
+	if( m_assignment ) {
+		// Replay the kept shift, which chooses the same disks, to note the sites of each
+		UdcPhaseTimer timer( m_stats, UdcCoverStats::ASSIGN );
+		const std::vector<uint32_t>& order = *m_order;
+		uint32_t disk = GetNDisks();
+		LLShift<Geometry>( P, radius, C - shiftCenters, [&]( double, double, const StripInterval* first, const StripInterval* last ) {
+			for( ; first != last; ++first )
+				m_assignment->Assign( order[first->site], disk );
+			disk++;
+		}, []() { return false; } );
+	}
+
+	for( const auto& p : *C )
+		Place( p.first, p.second );
+}
+
+} // namespace ns3
+
+#endif /* UDC_COVER_CORE_H */
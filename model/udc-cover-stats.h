@@ -0,0 +1,203 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_COVER_STATS_H
+#define UDC_COVER_STATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Build with UDC_STATS defined to 0 to compile the counters and timers
+ * out: UdcCounter and UdcPhaseTimer then do nothing, and every count and
+ * time in UdcCoverStats stays 0.
+ */
+#ifndef UDC_STATS
+#define UDC_STATS 1
+#endif
+
+namespace ns3 {
+
+#if UDC_STATS
+typedef uint64_t UdcCounter;
+#else
+/**
+ * \brief A counter that counts nothing, for builds without UDC_STATS.
+ */
+struct UdcCounter
+{
+  UdcCounter (uint64_t = 0)
+  {
+  }
+  UdcCounter &operator++ (void)
+  {
+    return *this;
+  }
+  UdcCounter &operator+= (uint64_t)
+  {
+    return *this;
+  }
+  operator uint64_t (void) const
+  {
+    return 0;
+  }
+};
+#endif
+
+/**
+ * \ingroup mobility
+ * \brief Where the time of a cover went, and counts of the work done.
+ *
+ * The algorithms count into local UdcCounters, per worker, and add them
+ * in once they finish, so counting costs an increment of a register or
+ * so.  The working set is estimated from the sizes of the main
+ * structures at the end of each phase, not measured.
+ */
+struct UdcCoverStats
+{
+  /**
+   * The phases of a cover, timed separately
+   */
+  enum Phase
+  {
+    CACHE = 0,  //!< hashing the sites and reading or writing the cover cache
+    COMPONENTS, //!< splitting the sites into components
+    SORT,       //!< sorting the sites on x
+    COVER,      //!< the algorithm proper
+    ASSIGN,     //!< finding and grouping the disk of each site
+    PLACE,      //!< adding the disks to the positions
+    PRUNE,      //!< PruneRedundant
+    INDEX,      //!< building the gateway index
+    VERIFY,     //!< VerifyCover
+    N_PHASES
+  };
+
+  /**
+   * \return the name of a phase, in lower case
+   */
+  static const char *GetPhaseName (Phase phase)
+  {
+    static const char *names[N_PHASES] = {"cache", "components", "sort", "cover", "assign",
+                                          "place", "prune", "index", "verify"};
+    return names[phase];
+  }
+
+  double seconds[N_PHASES] = {}; //!< wall-clock time of each phase
+  uint64_t cellProbes = 0;       //!< lattice cells looked up
+  uint64_t cellInserts = 0;      //!< lattice cells given a disk
+  uint64_t coverageTests = 0;    //!< distances of a site to a disk compared with the radius, outside SIMD kernels
+  uint64_t activeInserts = 0;    //!< disks put in the active set of SWEEP, the BST or the bands
+  uint64_t activeErases = 0;     //!< disks taken out of the BST of SWEEP, behind the sweep line
+  uint64_t deferred = 0;         //!< sites the parallel FAST_COVER replayed serially
+  uint64_t strips[6] = {};       //!< strips holding sites, in each shift of STRIPS
+  uint64_t disks = 0;            //!< disks placed
+  uint64_t peakBytes = 0;        //!< estimated largest working set
+
+  /**
+   * \brief Set every time and count to 0
+   */
+  void Clear (void)
+  {
+    *this = UdcCoverStats ();
+  }
+
+  /**
+   * \brief Add the times and counts of another cover, taking the larger
+   * working set
+   */
+  void Add (const UdcCoverStats &other)
+  {
+    for (int p = 0; p < N_PHASES; ++p)
+      {
+        seconds[p] += other.seconds[p];
+      }
+    cellProbes += other.cellProbes;
+    cellInserts += other.cellInserts;
+    coverageTests += other.coverageTests;
+    activeInserts += other.activeInserts;
+    activeErases += other.activeErases;
+    deferred += other.deferred;
+    for (int s = 0; s < 6; ++s)
+      {
+        strips[s] += other.strips[s];
+      }
+    disks += other.disks;
+    peakBytes = std::max (peakBytes, other.peakBytes);
+  }
+
+  /**
+   * \brief Note a working set of the given size
+   */
+  void NoteBytes (uint64_t bytes)
+  {
+#if UDC_STATS
+    peakBytes = std::max (peakBytes, bytes);
+#else
+    (void) bytes;
+#endif
+  }
+};
+
+/**
+ * \brief Adds the time until its destruction to a phase of a
+ * UdcCoverStats, if one is given and UDC_STATS is set.
+ */
+class UdcPhaseTimer
+{
+public:
+  UdcPhaseTimer (UdcCoverStats *stats, UdcCoverStats::Phase phase)
+#if UDC_STATS
+    : m_stats (stats),
+      m_phase (phase),
+      m_start (std::chrono::steady_clock::now ())
+#endif
+  {
+#if !UDC_STATS
+    (void) stats;
+    (void) phase;
+#endif
+  }
+
+  ~UdcPhaseTimer ()
+  {
+#if UDC_STATS
+    if (m_stats)
+      {
+        m_stats->seconds[m_phase] +=
+            std::chrono::duration<double> (std::chrono::steady_clock::now () - m_start).count ();
+      }
+#endif
+  }
+
+  UdcPhaseTimer (const UdcPhaseTimer &) = delete;
+  UdcPhaseTimer &operator= (const UdcPhaseTimer &) = delete;
+
+private:
+#if UDC_STATS
+  UdcCoverStats *m_stats;
+  UdcCoverStats::Phase m_phase;
+  std::chrono::steady_clock::time_point m_start;
+#endif
+};
+
+} // namespace ns3
+
+#endif /* UDC_COVER_STATS_H */
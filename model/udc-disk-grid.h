@@ -0,0 +1,317 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_DISK_GRID_H
+#define UDC_DISK_GRID_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief Static grid of points, for the points near a query.
+ *
+ * The points are sorted by cell into flat arrays, with the cells in
+ * row-major order, so each row of the 3x3 cells around a query is one
+ * contiguous range.  When the bounding box holds few enough cells, the
+ * range of every cell is kept in a dense table built in O(m) for m
+ * points.  Otherwise only the non-empty cells are kept, sorted, with the
+ * first of each row, and a query searches the cells of its three rows.
+ */
+class UdcDiskGrid
+{
+public:
+  /**
+   * \brief Index the points (x[i], y[i]).
+   * \param cellWidth the cell size; ForNear reaches every point closer
+   *        than this to the query
+   */
+  void Build (const std::vector<double> &x, const std::vector<double> &y, double cellWidth)
+  {
+    if (x.empty ())
+      {
+        Build (x, y, cellWidth, 0, 0, 0, 0);
+        return;
+      }
+    Build (x, y, cellWidth, *std::min_element (x.begin (), x.end ()), *std::min_element (y.begin (), y.end ()),
+           *std::max_element (x.begin (), x.end ()), *std::max_element (y.begin (), y.end ()));
+  }
+
+  /**
+   * \brief Index the points (x[i], y[i]) over a box the caller already
+   * knows to hold them all, with the first cell at its lower left corner.
+   * \param cellWidth the cell size, as for Build
+   * \param minX,minY,maxX,maxY the box
+   */
+  void Build (const std::vector<double> &x, const std::vector<double> &y, double cellWidth, double minX,
+              double minY, double maxX, double maxY)
+  {
+    const size_t m = x.size ();
+    m_width = cellWidth;
+    m_x.assign (m, 0);
+    m_y.assign (m, 0);
+    m_id.assign (m, 0);
+    m_start.clear ();
+    m_cells.clear ();
+    m_rowStart.clear ();
+    if (m == 0)
+      {
+        m_columns = m_rows = 0;
+        return;
+      }
+
+    m_minX = minX;
+    m_minY = minY;
+    m_columns = int64_t (std::floor ((maxX - m_minX) / m_width)) + 1;
+    m_rows = int64_t (std::floor ((maxY - m_minY) / m_width)) + 1;
+
+    const double cells = double (m_columns) * double (m_rows);
+    m_dense = cells <= std::max<double> (1 << 22, 8.0 * m);
+
+    std::vector<uint64_t> key (m);
+    const uint64_t cellCount = uint64_t (m_columns) * uint64_t (m_rows);
+    for (size_t i = 0; i < m; ++i)
+      {
+        key[i] = Key (Column (x[i]), Row (y[i]));
+      }
+
+    if (m_dense)
+      {
+        // Counting sort on the cell
+        m_start.assign (cellCount + 1, 0);
+        for (size_t i = 0; i < m; ++i)
+          {
+            ++m_start[key[i] + 1];
+          }
+        for (size_t c = 1; c < m_start.size (); ++c)
+          {
+            m_start[c] += m_start[c - 1];
+          }
+        std::vector<uint32_t> next (m_start.begin (), m_start.end () - 1);
+        for (size_t i = 0; i < m; ++i)
+          {
+            Place (next[key[i]]++, x[i], y[i], i);
+          }
+      }
+    else
+      {
+        std::vector<std::pair<uint64_t, uint32_t>> sorted (m);
+        for (size_t i = 0; i < m; ++i)
+          {
+            sorted[i] = {key[i], uint32_t (i)};
+          }
+        std::sort (sorted.begin (), sorted.end ());
+        for (size_t k = 0; k < m; ++k)
+          {
+            const uint32_t i = sorted[k].second;
+            Place (k, x[i], y[i], i);
+            if (k == 0 || sorted[k].first != sorted[k - 1].first)
+              {
+                m_cells.push_back (sorted[k].first);
+                m_start.push_back (k);
+              }
+          }
+        m_start.push_back (m);
+
+        // The first non-empty cell of every row, if there are not too many rows
+        if (m_rows <= std::max<int64_t> (1 << 22, 8 * int64_t (m)))
+          {
+            m_rowStart.assign (m_rows + 1, 0);
+            for (uint64_t cell : m_cells)
+              {
+                ++m_rowStart[cell / m_columns + 1];
+              }
+            for (size_t r = 1; r < m_rowStart.size (); ++r)
+              {
+                m_rowStart[r] += m_rowStart[r - 1];
+              }
+          }
+      }
+  }
+
+  size_t GetN (void) const
+  {
+    return m_x.size ();
+  }
+
+  /**
+   * \brief Call f (k) for every point k in the 3x3 cells around (x, y).
+   *
+   * k indexes X, Y and Id, not the order the points were given in.
+   */
+  template <typename F>
+  void ForNear (double x, double y, F f) const
+  {
+    if (m_x.empty ())
+      {
+        return;
+      }
+    const int64_t column = Column (x), row = Row (y);
+    for (int64_t r = row - 1; r <= row + 1; ++r)
+      {
+        ForRow (r, column - 1, column + 1, f);
+      }
+  }
+
+  /**
+   * \brief Call f (k) for every point k in the cells exactly ring cells
+   * away from the cell of (x, y), across or along.
+   *
+   * Ring 0 is the cell of (x, y) itself.  A point in ring r is at least
+   * (r - 1) cell widths from (x, y), and the points of rings 0 to r - 1
+   * are all those closer than that, so searches can stop at the ring
+   * past their answer.
+   */
+  template <typename F>
+  void ForRing (double x, double y, int64_t ring, F f) const
+  {
+    if (m_x.empty ())
+      {
+        return;
+      }
+    const int64_t column = Column (x), row = Row (y);
+    ForRow (row - ring, column - ring, column + ring, f);
+    if (ring == 0)
+      {
+        return;
+      }
+    for (int64_t r = std::max (row - ring + 1, int64_t (0)); r <= std::min (row + ring - 1, m_rows - 1); ++r)
+      {
+        ForRow (r, column - ring, column - ring, f);
+        ForRow (r, column + ring, column + ring, f);
+      }
+    ForRow (row + ring, column - ring, column + ring, f);
+  }
+
+  /**
+   * \brief The rings around (x, y), see ForRing, that hold cells of the grid.
+   */
+  void GetRings (double x, double y, int64_t &first, int64_t &last) const
+  {
+    const int64_t column = Column (x), row = Row (y);
+    first = std::max ({int64_t (0), column - (m_columns - 1), -column, row - (m_rows - 1), -row});
+    last = std::max ({column, m_columns - 1 - column, row, m_rows - 1 - row});
+  }
+
+  /**
+   * \return the cell size given to Build
+   */
+  double GetCellWidth (void) const
+  {
+    return m_width;
+  }
+
+  double X (size_t k) const
+  {
+    return m_x[k];
+  }
+
+  double Y (size_t k) const
+  {
+    return m_y[k];
+  }
+
+  /**
+   * \return the index the point k was given at
+   */
+  uint32_t Id (size_t k) const
+  {
+    return m_id[k];
+  }
+
+private:
+  /**
+   * Call f (k) for every point k in row r, from column firstColumn to
+   * lastColumn, clipped to the grid.
+   */
+  template <typename F>
+  void ForRow (int64_t r, int64_t firstColumn, int64_t lastColumn, F f) const
+  {
+    firstColumn = std::max<int64_t> (firstColumn, 0);
+    lastColumn = std::min<int64_t> (lastColumn, m_columns - 1);
+    if (r < 0 || r >= m_rows || firstColumn > lastColumn)
+      {
+        return;
+      }
+    if (m_dense)
+      {
+        const uint32_t end = m_start[Key (lastColumn, r) + 1];
+        for (uint32_t k = m_start[Key (firstColumn, r)]; k < end; ++k)
+          {
+            f (k);
+          }
+        return;
+      }
+    auto rowBegin = m_cells.begin (), rowEnd = m_cells.end ();
+    if (!m_rowStart.empty ())
+      {
+        rowBegin = m_cells.begin () + m_rowStart[r];
+        rowEnd = m_cells.begin () + m_rowStart[r + 1];
+      }
+    auto first = std::lower_bound (rowBegin, rowEnd, Key (firstColumn, r));
+    auto last = std::upper_bound (first, rowEnd, Key (lastColumn, r));
+    const uint32_t end = m_start[last - m_cells.begin ()];
+    for (uint32_t k = m_start[first - m_cells.begin ()]; k < end; ++k)
+      {
+        f (k);
+      }
+  }
+
+  int64_t Column (double x) const
+  {
+    return int64_t (std::floor ((x - m_minX) / m_width));
+  }
+
+  int64_t Row (double y) const
+  {
+    return int64_t (std::floor ((y - m_minY) / m_width));
+  }
+
+  uint64_t Key (int64_t column, int64_t row) const
+  {
+    return uint64_t (row) * uint64_t (m_columns) + uint64_t (column);
+  }
+
+  void Place (size_t k, double x, double y, size_t id)
+  {
+    m_x[k] = x;
+    m_y[k] = y;
+    m_id[k] = uint32_t (id);
+  }
+
+  double m_width = 1;
+  double m_minX = 0, m_minY = 0;
+  int64_t m_columns = 0, m_rows = 0;
+  bool m_dense = true;
+  std::vector<double> m_x, m_y; //!< the points, sorted by cell
+  std::vector<uint32_t> m_id;   //!< original index of each sorted point
+  std::vector<uint32_t> m_start; //!< first point of each (dense: every, sparse: non-empty) cell, and the end
+  std::vector<uint64_t> m_cells; //!< sparse: the non-empty cells, sorted
+  std::vector<uint32_t> m_rowStart; //!< sparse: first of m_cells in each row, and the end, if not too many rows
+};
+
+} // namespace ns3
+
+#endif /* UDC_DISK_GRID_H */
@@ -0,0 +1,307 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#include "udc-external-sort.h"
+#include "udc-radix-sort.h"
+#include "udc-site-store.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <queue>
+#include <utility>
+
+namespace ns3 {
+
+// The smallest buffer a run is merged through
+static const uint64_t MIN_RUN_BUFFER_BYTES = 1 << 16;
+
+/*
+ * A run file being written, as interleaved x and y.
+ */
+struct RunWriter
+{
+  explicit RunWriter (const std::string &name)
+    : out (name, std::ios::binary | std::ios::trunc)
+  {
+    buffer.reserve (MIN_RUN_BUFFER_BYTES / sizeof (double));
+  }
+
+  void Push (double x, double y)
+  {
+    buffer.push_back (x);
+    buffer.push_back (y);
+    if (buffer.size () == buffer.capacity ())
+      {
+        Flush ();
+      }
+  }
+
+  bool Finish (void)
+  {
+    Flush ();
+    return bool (out.flush ());
+  }
+
+  void Flush (void)
+  {
+    out.write (reinterpret_cast<const char *> (buffer.data ()), buffer.size () * sizeof (double));
+    buffer.clear ();
+  }
+
+  std::ofstream out;
+  std::vector<double> buffer;
+};
+
+/*
+ * A run file being read back, a buffer at a time.
+ */
+struct RunReader
+{
+  bool Open (const std::string &name, size_t bufferSites)
+  {
+    in.open (name, std::ios::binary);
+    buffer.resize (2 * bufferSites);
+    return bool (in);
+  }
+
+  bool Next (double &x, double &y)
+  {
+    if (next == end)
+      {
+        in.read (reinterpret_cast<char *> (buffer.data ()), buffer.size () * sizeof (double));
+        end = size_t (in.gcount ()) / sizeof (double) & ~size_t (1);
+        next = 0;
+        if (end == 0)
+          {
+            return false;
+          }
+      }
+    x = buffer[next];
+    y = buffer[next + 1];
+    next += 2;
+    return true;
+  }
+
+  std::ifstream in;
+  std::vector<double> buffer;
+  size_t next = 0, end = 0;
+};
+
+UdcExternalSort::UdcExternalSort (uint64_t budget, const std::string &tempPrefix)
+  : m_budget (budget),
+    m_tempPrefix (tempPrefix)
+{
+}
+
+UdcExternalSort::~UdcExternalSort ()
+{
+  RemoveRuns ();
+}
+
+bool
+UdcExternalSort::Sort (const std::string &siteFile, UdcThreadPool &pool)
+{
+  RemoveRuns ();
+  m_x.clear ();
+  m_y.clear ();
+  m_n = 0;
+
+  UdcSiteFileReader reader;
+  if (!reader.Open (siteFile))
+    {
+      return false;
+    }
+  m_n = reader.GetN ();
+  const size_t runSites = std::max<uint64_t> (4096, std::min<uint64_t> (m_budget / GetBytesPerSite (), UINT32_MAX));
+
+  std::vector<double> x, y;
+  for (uint64_t done = 0; done < m_n;)
+    {
+      const size_t count = std::min<uint64_t> (runSites, m_n - done);
+      x.resize (count);
+      y.resize (count);
+      if (reader.Read (x.data (), y.data (), count) != count)
+        {
+          return false;
+        }
+      if (done == 0)
+        {
+          m_minX = m_maxX = x[0];
+          m_minY = m_maxY = y[0];
+        }
+      for (size_t i = 0; i < count; ++i)
+        {
+          m_minX = std::min (m_minX, x[i]);
+          m_minY = std::min (m_minY, y[i]);
+          m_maxX = std::max (m_maxX, x[i]);
+          m_maxY = std::max (m_maxY, y[i]);
+        }
+      done += count;
+
+      std::vector<uint32_t> order (count);
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          order[i] = i;
+        }
+      ParallelRadixSort (order, [&x] (uint32_t i) { return x[i]; }, pool);
+
+      if (count == m_n)
+        {
+          m_x.resize (count);
+          m_y.resize (count);
+          for (size_t k = 0; k < count; ++k)
+            {
+              m_x[k] = x[order[k]];
+              m_y[k] = y[order[k]];
+            }
+          return true;
+        }
+
+      const std::string name = NewRunName ();
+      RunWriter run (name);
+      for (size_t k = 0; k < count; ++k)
+        {
+          run.Push (x[order[k]], y[order[k]]);
+        }
+      if (!run.Finish ())
+        {
+          return false;
+        }
+      m_runs.push_back (name);
+    }
+  std::vector<double> ().swap (x);
+  std::vector<double> ().swap (y);
+
+  // Merge consecutive runs in groups, which keeps equal x in file order,
+  // until a buffer of each run fits in half the budget
+  const size_t fanIn = std::max<uint64_t> (2, m_budget / 2 / MIN_RUN_BUFFER_BYTES);
+  while (m_runs.size () > fanIn)
+    {
+      std::vector<std::string> merged;
+      for (size_t g = 0; g < m_runs.size (); g += fanIn)
+        {
+          const std::vector<std::string> group (m_runs.begin () + g,
+                                                m_runs.begin () + std::min (g + fanIn, m_runs.size ()));
+          if (group.size () == 1)
+            {
+              merged.push_back (group[0]);
+              continue;
+            }
+          const std::string name = NewRunName ();
+          RunWriter run (name);
+          if (!Merge (group, MIN_RUN_BUFFER_BYTES / (2 * sizeof (double)),
+                      [&run] (double x, double y) { run.Push (x, y); })
+              || !run.Finish ())
+            {
+              return false;
+            }
+          for (const std::string &r : group)
+            {
+              std::remove (r.c_str ());
+            }
+          merged.push_back (name);
+        }
+      m_runs.swap (merged);
+    }
+  return true;
+}
+
+bool
+UdcExternalSort::ForEach (const std::function<void (double, double)> &f)
+{
+  if (m_runs.empty ())
+    {
+      for (size_t k = 0; k < m_x.size (); ++k)
+        {
+          f (m_x[k], m_y[k]);
+        }
+      return m_x.size () == m_n;
+    }
+  const size_t bufferSites = std::max<uint64_t> (MIN_RUN_BUFFER_BYTES, m_budget / 2 / m_runs.size ())
+                             / (2 * sizeof (double));
+  uint64_t merged = 0;
+  return Merge (m_runs, bufferSites, [&] (double x, double y) {
+           ++merged;
+           f (x, y);
+         })
+         && merged == m_n;
+}
+
+bool
+UdcExternalSort::Merge (const std::vector<std::string> &runs, size_t bufferSites,
+                        const std::function<void (double, double)> &f)
+{
+  std::vector<RunReader> readers (runs.size ());
+  std::vector<double> headY (runs.size ());
+  // The head of every run, least x first, then the earlier run
+  typedef std::pair<double, size_t> Head;
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+  for (size_t r = 0; r < runs.size (); ++r)
+    {
+      double x;
+      if (!readers[r].Open (runs[r], bufferSites))
+        {
+          return false;
+        }
+      if (readers[r].Next (x, headY[r]))
+        {
+          heads.emplace (x, r);
+        }
+    }
+
+  while (!heads.empty ())
+    {
+      const Head head = heads.top ();
+      heads.pop ();
+      f (head.first, headY[head.second]);
+      double x;
+      if (readers[head.second].Next (x, headY[head.second]))
+        {
+          heads.emplace (x, head.second);
+        }
+    }
+  for (const RunReader &reader : readers)
+    {
+      if (reader.in.bad ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+std::string
+UdcExternalSort::NewRunName (void)
+{
+  return m_tempPrefix + ".run" + std::to_string (m_runsNamed++);
+}
+
+void
+UdcExternalSort::RemoveRuns (void)
+{
+  for (unsigned k = 0; k < m_runsNamed; ++k)
+    {
+      std::remove ((m_tempPrefix + ".run" + std::to_string (k)).c_str ());
+    }
+  m_runsNamed = 0;
+  m_runs.clear ();
+}
+
+} // namespace ns3
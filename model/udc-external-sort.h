@@ -0,0 +1,126 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_EXTERNAL_SORT_H
+#define UDC_EXTERNAL_SORT_H
+
+#include "udc-thread-pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief The sites of a site file sorted on x within a memory budget.
+ *
+ * The file is read in runs that fit the budget, each run is radix sorted
+ * and written to a temporary file, and the runs are merged as they are
+ * streamed.  Runs that are too many to merge at once, with a buffer of
+ * each in the budget, are first merged in groups.  A file that fits in a
+ * single run is sorted in memory and never written out.
+ *
+ * Sites with equal x keep their order in the file, so the stream is the
+ * order UDCPositionAllocator sorts the same sites in.
+ */
+class UdcExternalSort
+{
+public:
+  /**
+   * \param budget the bytes the sort may use
+   * \param tempPrefix the path the run files are named after
+   */
+  UdcExternalSort (uint64_t budget, const std::string &tempPrefix);
+  ~UdcExternalSort ();
+  UdcExternalSort (const UdcExternalSort &) = delete;
+  UdcExternalSort &operator= (const UdcExternalSort &) = delete;
+
+  /**
+   * \brief Read and sort the sites of a site file.
+   * \return false if the file cannot be read or a run cannot be written
+   */
+  bool Sort (const std::string &siteFile, UdcThreadPool &pool);
+
+  /**
+   * \brief Call f (x, y) for every site, in order of x.
+   * \return false if a run cannot be read back
+   */
+  bool ForEach (const std::function<void (double, double)> &f);
+
+  uint64_t GetN (void) const
+  {
+    return m_n;
+  }
+
+  double GetMinX (void) const
+  {
+    return m_minX;
+  }
+
+  double GetMinY (void) const
+  {
+    return m_minY;
+  }
+
+  double GetMaxX (void) const
+  {
+    return m_maxX;
+  }
+
+  double GetMaxY (void) const
+  {
+    return m_maxY;
+  }
+
+  /**
+   * \return the bytes one site takes while its run is sorted
+   */
+  static uint64_t GetBytesPerSite (void)
+  {
+    return 48;
+  }
+
+private:
+  /**
+   * \brief Merge runs, calling f (x, y) in order of x, with a buffer of
+   * bufferSites sites for each run.
+   */
+  bool Merge (const std::vector<std::string> &runs, size_t bufferSites,
+              const std::function<void (double, double)> &f);
+
+  std::string NewRunName (void);
+
+  void RemoveRuns (void);
+
+  uint64_t m_budget;
+  std::string m_tempPrefix;
+  unsigned m_runsNamed = 0;
+  std::vector<std::string> m_runs; //!< the sorted runs, in file order
+  std::vector<double> m_x, m_y;    //!< the sorted sites, if they fit in one run
+  uint64_t m_n = 0;
+  double m_minX = 0, m_minY = 0, m_maxX = 0, m_maxY = 0;
+};
+
+} // namespace ns3
+
+#endif /* UDC_EXTERNAL_SORT_H */
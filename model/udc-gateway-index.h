@@ -0,0 +1,246 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_GATEWAY_INDEX_H
+#define UDC_GATEWAY_INDEX_H
+
+#include "udc-disk-grid.h"
+#include "udc-thread-pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief Nearest, k nearest and range queries over the gateways of a cover.
+ *
+ * The gateways are kept in a UdcDiskGrid whose cells are about one radius
+ * wide, so a cell holds a gateway or two.  A query scans the rings of
+ * cells around its point outwards and stops at the first ring that can
+ * hold nothing closer than what it has found, which for a point inside
+ * the cover is two or three rings.
+ *
+ * The index does not change once built, so any number of threads may
+ * query it at once.  The batch queries split their points over the
+ * workers of a pool.
+ */
+class UdcGatewayIndex
+{
+public:
+  static constexpr uint32_t NONE = UINT32_MAX; //!< no gateway
+
+  /**
+   * \brief Take over a grid of the gateways.
+   */
+  void Build (UdcDiskGrid &&grid)
+  {
+    m_grid = std::move (grid);
+  }
+
+  /**
+   * \return the number of gateways
+   */
+  size_t GetN (void) const
+  {
+    return m_grid.GetN ();
+  }
+
+  /**
+   * \return the gateway nearest to (x, y), or NONE if there are none
+   */
+  uint32_t Nearest (double x, double y) const
+  {
+    uint32_t gateway = NONE;
+    double nearest = std::numeric_limits<double>::infinity ();
+    int64_t ring, lastRing;
+    m_grid.GetRings (x, y, ring, lastRing);
+    const double width = m_grid.GetCellWidth ();
+    for (; m_grid.GetN () > 0 && ring <= lastRing; ++ring)
+      {
+        // Nothing beyond ring r - 1 is closer than (r - 1) widths
+        const double reach = (ring - 1) * width;
+        if (gateway != NONE && ring > 0 && nearest < reach * reach)
+          {
+            break;
+          }
+        m_grid.ForRing (x, y, ring, [&] (size_t d) {
+          const double dx = x - m_grid.X (d), dy = y - m_grid.Y (d);
+          const double distance = dx * dx + dy * dy;
+          if (distance < nearest || (distance == nearest && m_grid.Id (d) < gateway))
+            {
+              nearest = distance;
+              gateway = m_grid.Id (d);
+            }
+        });
+      }
+    return gateway;
+  }
+
+  /**
+   * \brief Find the k gateways nearest to (x, y), nearest first, ties
+   * broken by gateway.
+   * \param gateways where the k gateways go, padded with NONE if there
+   *        are fewer
+   */
+  void Nearest (double x, double y, size_t k, uint32_t *gateways) const
+  {
+    std::vector<std::pair<double, uint32_t>> best;
+    Nearest (x, y, k, gateways, best);
+  }
+
+  /**
+   * \brief Call f (gateway) for every gateway within range of (x, y).
+   */
+  template <typename F>
+  void ForWithin (double x, double y, double range, F f) const
+  {
+    if (m_grid.GetN () == 0)
+      {
+        return;
+      }
+    int64_t ring, lastRing;
+    m_grid.GetRings (x, y, ring, lastRing);
+    const double rangeSquared = range * range;
+    lastRing = std::min<int64_t> (lastRing, int64_t (std::floor (range / m_grid.GetCellWidth ())) + 1);
+    for (; ring <= lastRing; ++ring)
+      {
+        m_grid.ForRing (x, y, ring, [&] (size_t d) {
+          const double dx = x - m_grid.X (d), dy = y - m_grid.Y (d);
+          if (dx * dx + dy * dy <= rangeSquared)
+            {
+              f (m_grid.Id (d));
+            }
+        });
+      }
+  }
+
+  /**
+   * \brief Find the k nearest gateways of each of n points, in parallel.
+   * \param gateways where the k gateways of point i go, at i * k, as
+   *        Nearest (x, y, k, gateways) puts them
+   */
+  void Nearest (const double *x, const double *y, size_t n, size_t k, uint32_t *gateways, UdcThreadPool &pool) const
+  {
+    const size_t chunks = std::min<size_t> (pool.GetN () * 4, (n + 4095) / 4096);
+    pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+      std::vector<std::pair<double, uint32_t>> best;
+      for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i)
+        {
+          if (k == 1)
+            {
+              gateways[i] = Nearest (x[i], y[i]);
+            }
+          else
+            {
+              Nearest (x[i], y[i], k, gateways + i * k, best);
+            }
+        }
+    });
+  }
+
+  /**
+   * \brief Find the gateways within range of each of n points, in parallel.
+   *
+   * The gateways of point i are gateways[first[i]] to gateways[first[i + 1] - 1],
+   * in no particular order.
+   */
+  void Within (const double *x, const double *y, size_t n, double range, std::vector<uint64_t> &first,
+               std::vector<uint32_t> &gateways, UdcThreadPool &pool) const
+  {
+    // Each chunk lists its own gateways, which are then put together
+    const size_t chunks = std::min<size_t> (pool.GetN () * 4, (n + 4095) / 4096);
+    std::vector<std::vector<uint32_t>> found (chunks);
+    first.assign (n + 1, 0);
+    pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+      for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i)
+        {
+          ForWithin (x[i], y[i], range, [&] (uint32_t g) { found[c].push_back (g); });
+          first[i + 1] = found[c].size ();
+        }
+    });
+
+    std::vector<uint64_t> offset (chunks + 1, 0);
+    for (size_t c = 0; c < chunks; ++c)
+      {
+        offset[c + 1] = offset[c] + found[c].size ();
+      }
+    gateways.resize (offset[chunks]);
+    pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+      std::copy (found[c].begin (), found[c].end (), gateways.begin () + offset[c]);
+      for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i)
+        {
+          first[i + 1] += offset[c];
+        }
+    });
+  }
+
+private:
+  /**
+   * Nearest (x, y, k, gateways), with the heap of the best gateways so
+   * far, as (squared distance, gateway), in a buffer of the caller
+   */
+  void Nearest (double x, double y, size_t k, uint32_t *gateways, std::vector<std::pair<double, uint32_t>> &best) const
+  {
+    best.clear ();
+    int64_t ring, lastRing;
+    m_grid.GetRings (x, y, ring, lastRing);
+    const double width = m_grid.GetCellWidth ();
+    for (; k > 0 && m_grid.GetN () > 0 && ring <= lastRing; ++ring)
+      {
+        // Nothing beyond ring r - 1 is closer than (r - 1) widths
+        const double reach = (ring - 1) * width;
+        if (best.size () == k && ring > 0 && best.front ().first < reach * reach)
+          {
+            break;
+          }
+        m_grid.ForRing (x, y, ring, [&] (size_t d) {
+          const double dx = x - m_grid.X (d), dy = y - m_grid.Y (d);
+          const std::pair<double, uint32_t> candidate (dx * dx + dy * dy, m_grid.Id (d));
+          if (best.size () < k || candidate < best.front ())
+            {
+              best.push_back (candidate);
+              std::push_heap (best.begin (), best.end ());
+              if (best.size () > k)
+                {
+                  std::pop_heap (best.begin (), best.end ());
+                  best.pop_back ();
+                }
+            }
+        });
+      }
+    std::sort_heap (best.begin (), best.end ());
+    for (size_t j = 0; j < k; ++j)
+      {
+        gateways[j] = j < best.size () ? best[j].second : NONE;
+      }
+  }
+
+  UdcDiskGrid m_grid; //!< the gateways, ids as in the cover
+};
+
+} // namespace ns3
+
+#endif /* UDC_GATEWAY_INDEX_H */
@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_GEOMETRY_H
+#define UDC_GEOMETRY_H
+
+#include <cfloat>
+#include <cmath>
+
+namespace ns3 {
+
+/*
+ * The geometry policies of the UdcCover algorithms.  A policy gives
+ *
+ *   Real                            the type of a squared distance
+ *   Strip                           the type of the strip positions of LL
+ *   SquaredDistance (ax, ay, bx, by)  the squared distance of two points
+ *   Chord (radius, distance)        half the chord a disk of the radius
+ *                                   leaves on a line the given distance
+ *                                   from its center
+ *
+ * and is chosen at compile time, so that its arithmetic is inlined into
+ * the loops of the algorithms.  The coordinates are doubles whatever the
+ * policy.  UdcCgalGeometry, in udc-cgal-geometry.h, is the reference.
+ */
+
+/**
+ * \ingroup mobility
+ * \brief Geometry in plain double arithmetic.
+ *
+ * Decides every distance test as UdcCgalGeometry does; the strips of LL
+ * are placed in double rather than long double, which can move a disk
+ * by a rounding error.
+ */
+struct UdcDoubleGeometry
+{
+  typedef double Real;
+  typedef double Strip;
+
+  static double SquaredDistance (double ax, double ay, double bx, double by)
+  {
+    const double dx = ax - bx, dy = ay - by;
+    return dx * dx + dy * dy;
+  }
+
+  static double Chord (double radius, double distance)
+  {
+    return std::sqrt (radius * radius - distance * distance);
+  }
+};
+
+/**
+ * \brief Geometry in single precision arithmetic.
+ *
+ * The differences of the coordinates are taken in double and everything
+ * after in float.  Squared distances are rounded up, and chords down, by
+ * more than the float rounding can err, so a site is never taken for
+ * covered when it is not; a site near the edge of a disk may get a disk
+ * of its own instead.
+ */
+struct UdcFloatGeometry
+{
+  typedef float Real;
+  typedef double Strip;
+
+  static float SquaredDistance (double ax, double ay, double bx, double by)
+  {
+    const float dx = float (ax - bx), dy = float (ay - by);
+    return (dx * dx + dy * dy) * (1 + 8 * FLT_EPSILON);
+  }
+
+  static double Chord (double radius, double distance)
+  {
+    const float r = float (radius), d = float (distance);
+    const float squared = (r * r - d * d) - 8 * FLT_EPSILON * (r * r);
+    return squared > 0 ? std::sqrt (squared) * (1 - 2 * FLT_EPSILON) : 0;
+  }
+};
+
+} // namespace ns3
+
+#endif /* UDC_GEOMETRY_H */
@@ -0,0 +1,211 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#include "udc-layout.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+
+#include <unistd.h>
+
+namespace ns3 {
+
+// The longer side of the drawing, and the margin around it
+static const double LAYOUT_SIZE = 1000;
+static const double LAYOUT_MARGIN = 20;
+// Room below the drawing for the scale bar
+static const double LAYOUT_FOOTER = 40;
+// The radius of a site drawn on its own
+static const double LAYOUT_SITE_RADIUS = 1.5;
+
+UdcLayout::UdcLayout (double minX, double minY, double maxX, double maxY, size_t pointBudget)
+  : m_minX (minX),
+    m_maxY (maxY),
+    m_budget (std::max<size_t> (pointBudget, 1))
+{
+  const double span = std::max (std::max (maxX - minX, maxY - minY), 1e-9);
+  m_scale = LAYOUT_SIZE / span;
+  m_width = (maxX - minX) * m_scale + 2 * LAYOUT_MARGIN;
+  m_height = (maxY - minY) * m_scale + 2 * LAYOUT_MARGIN + LAYOUT_FOOTER;
+  m_tiles = std::max<size_t> (1, std::sqrt (double (m_budget)));
+  m_tileWidth = span / m_tiles;
+}
+
+size_t
+UdcLayout::TileOf (double x, double y) const
+{
+  const double column = std::floor ((x - m_minX) / m_tileWidth),
+               row = std::floor ((m_maxY - y) / m_tileWidth);
+  const size_t last = m_tiles - 1;
+  return std::min<size_t> (std::max (row, 0.0), last) * m_tiles + std::min<size_t> (std::max (column, 0.0), last);
+}
+
+void
+UdcLayout::SetSites (const UdcSiteStore &sites, UdcThreadPool &pool)
+{
+  m_sites = Layer ();
+  const size_t n = sites.GetN ();
+  if (n <= m_budget)
+    {
+      m_sites.x.resize (n);
+      m_sites.y.resize (n);
+      sites.Decode (0, n, m_sites.x.data (), m_sites.y.data ());
+      return;
+    }
+
+  // Each worker counts a range of the sites on its own grid, added up after
+  m_sites.tiled = true;
+  const size_t chunks = pool.GetN ();
+  std::vector<std::vector<uint32_t>> counts (chunks);
+  pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+    std::vector<uint32_t> &count = counts[c];
+    count.assign (m_tiles * m_tiles, 0);
+    const size_t BLOCK = 256;
+    double x[BLOCK], y[BLOCK];
+    for (size_t first = n * c / chunks; first < n * (c + 1) / chunks; first += BLOCK)
+      {
+        const size_t size = std::min (BLOCK, n * (c + 1) / chunks - first);
+        sites.Decode (first, size, x, y);
+        for (size_t k = 0; k < size; ++k)
+          {
+            ++count[TileOf (x[k], y[k])];
+          }
+      }
+  });
+  m_sites.counts.swap (counts[0]);
+  for (size_t c = 1; c < chunks; ++c)
+    {
+      for (size_t t = 0; t < m_sites.counts.size (); ++t)
+        {
+          m_sites.counts[t] += counts[c][t];
+        }
+    }
+}
+
+void
+UdcLayout::SetDisks (const double *x, const double *y, size_t n, double radius)
+{
+  m_disks = Layer ();
+  m_radius = radius;
+  if (n <= m_budget)
+    {
+      m_disks.x.assign (x, x + n);
+      m_disks.y.assign (y, y + n);
+      return;
+    }
+  m_disks.tiled = true;
+  m_disks.counts.assign (m_tiles * m_tiles, 0);
+  for (size_t i = 0; i < n; ++i)
+    {
+      ++m_disks.counts[TileOf (x[i], y[i])];
+    }
+}
+
+bool
+UdcLayout::WriteTiles (std::FILE *out, const Layer &layer, const char *id, const char *color) const
+{
+  const uint32_t most = *std::max_element (layer.counts.begin (), layer.counts.end ());
+  const double side = m_tileWidth * m_scale, shade = std::log1p (double (most));
+  bool ok = std::fprintf (out, "<g id=\"%s\" fill=\"%s\">\n", id, color) > 0;
+  for (size_t t = 0; ok && t < layer.counts.size (); ++t)
+    {
+      if (layer.counts[t] > 0)
+        {
+          ok = std::fprintf (out, "<rect x=\"%.1f\" y=\"%.1f\" width=\"%.2f\" height=\"%.2f\" fill-opacity=\"%.2f\"/>\n",
+                             LAYOUT_MARGIN + (t % m_tiles) * side, LAYOUT_MARGIN + (t / m_tiles) * side, side, side,
+                             0.1 + 0.9 * std::log1p (double (layer.counts[t])) / shade) > 0;
+        }
+    }
+  return ok && std::fprintf (out, "</g>\n") > 0;
+}
+
+bool
+UdcLayout::WriteSvg (const std::string &path) const
+{
+  // Write beside the final name, then rename over it in one step
+  static std::atomic<unsigned> written (0);
+  const std::string temporary = path + ".tmp" + std::to_string (getpid ()) + "." + std::to_string (written++);
+  std::FILE *out = std::fopen (temporary.c_str (), "w");
+  if (!out)
+    {
+      return false;
+    }
+  std::setvbuf (out, nullptr, _IOFBF, 1 << 16);
+
+  auto X = [this] (double x) { return LAYOUT_MARGIN + (x - m_minX) * m_scale; };
+  auto Y = [this] (double y) { return LAYOUT_MARGIN + (m_maxY - y) * m_scale; };
+
+  bool ok = std::fprintf (out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                          "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"0 0 %.1f %.1f\" "
+                          "width=\"%.0f\" height=\"%.0f\">\n"
+                          "<rect width=\"100%%\" height=\"100%%\" fill=\"white\"/>\n",
+                          m_width, m_height, m_width, m_height) > 0;
+
+  if (m_disks.tiled)
+    {
+      ok = ok && WriteTiles (out, m_disks, "disks", "#e06666");
+    }
+  else
+    {
+      ok = ok && std::fprintf (out, "<g id=\"disks\" fill=\"red\" fill-opacity=\"0.05\" stroke=\"#e06666\" "
+                               "stroke-width=\"0.5\">\n") > 0;
+      for (size_t i = 0; ok && i < m_disks.x.size (); ++i)
+        {
+          ok = std::fprintf (out, "<circle cx=\"%.1f\" cy=\"%.1f\" r=\"%.2f\"/>\n", X (m_disks.x[i]), Y (m_disks.y[i]),
+                             m_radius * m_scale) > 0;
+        }
+      ok = ok && std::fprintf (out, "</g>\n") > 0;
+    }
+
+  if (m_sites.tiled)
+    {
+      ok = ok && WriteTiles (out, m_sites, "sites", "blue");
+    }
+  else
+    {
+      ok = ok && std::fprintf (out, "<g id=\"sites\" fill=\"blue\" fill-opacity=\"0.63\">\n") > 0;
+      for (size_t i = 0; ok && i < m_sites.x.size (); ++i)
+        {
+          ok = std::fprintf (out, "<circle cx=\"%.1f\" cy=\"%.1f\" r=\"%.1f\"/>\n", X (m_sites.x[i]), Y (m_sites.y[i]),
+                             LAYOUT_SITE_RADIUS) > 0;
+        }
+      ok = ok && std::fprintf (out, "</g>\n") > 0;
+    }
+
+  // A bar one disk diameter long at the bottom right
+  const double length = 2 * m_radius * m_scale, right = m_width - LAYOUT_MARGIN,
+               bar = m_height - LAYOUT_FOOTER / 2;
+  ok = ok && std::fprintf (out, "<g id=\"scale\" stroke=\"black\" stroke-width=\"2\">\n"
+                           "<path d=\"M%.1f %.1fv-6v12v-6h%.1fv-6v12\" fill=\"none\"/>\n"
+                           "<text x=\"%.1f\" y=\"%.1f\" stroke=\"none\" font-size=\"12\" "
+                           "text-anchor=\"middle\">%.0f m</text>\n</g>\n</svg>\n",
+                           right - length, bar, length, right - length / 2, bar + 16, 2 * m_radius) > 0;
+
+  ok = !std::ferror (out) && ok;
+  if (std::fclose (out) != 0 || !ok || std::rename (temporary.c_str (), path.c_str ()) != 0)
+    {
+      std::remove (temporary.c_str ());
+      return false;
+    }
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_LAYOUT_H
+#define UDC_LAYOUT_H
+
+#include "udc-site-store.h"
+#include "udc-thread-pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief A drawing of sites and the disks covering them, of bounded size,
+ * written as SVG.
+ *
+ * Each layer, the sites and the disks, keeps its points while there are
+ * no more than the point budget of them, and otherwise only the number of
+ * points in each tile of a grid of at most that many tiles over the
+ * bounds, drawn as squares shaded by density.  So a layout holds, and its
+ * file takes, about the same space for a billion sites as for the budget,
+ * and once built it no longer refers to the sites; it can be written on
+ * another thread while they change.
+ *
+ * Nothing here depends on ns-3, nor runs any other program.
+ */
+class UdcLayout
+{
+public:
+  /**
+   * \param minX the least x of the points, or less
+   * \param minY the least y of the points, or less
+   * \param maxX the greatest x of the points, or more
+   * \param maxY the greatest y of the points, or more
+   * \param pointBudget the most points drawn one by one in each layer,
+   *        and the most tiles
+   */
+  UdcLayout (double minX, double minY, double maxX, double maxY, size_t pointBudget);
+
+  /**
+   * \brief Draw the sites, tiling them on the workers of pool if there
+   * are more than the budget
+   */
+  void SetSites (const UdcSiteStore &sites, UdcThreadPool &pool);
+
+  /**
+   * \brief Draw the disks of the given radius centered at (x[i], y[i])
+   */
+  void SetDisks (const double *x, const double *y, size_t n, double radius);
+
+  /**
+   * \brief Write the layout as SVG, a thousand units on its longer side,
+   * with a scale bar of one disk diameter
+   *
+   * The file is streamed out element by element, beside path, and renamed
+   * into place once complete, so a reader never sees part of it.
+   *
+   * \return false if the file cannot be written
+   */
+  bool WriteSvg (const std::string &path) const;
+
+private:
+  /**
+   * Points drawn one by one, or counted per tile
+   */
+  struct Layer
+  {
+    bool tiled = false;
+    std::vector<double> x, y; //!< the points, if not tiled
+    std::vector<uint32_t> counts; //!< points in each tile, row by row, if tiled
+  };
+
+  /**
+   * \return the tile holding (x, y), clamped to the grid
+   */
+  size_t TileOf (double x, double y) const;
+
+  /**
+   * \brief Write the tiles of a layer as squares of the given color,
+   * shaded from faint to solid as the count goes from 1 to the largest
+   */
+  bool WriteTiles (std::FILE *out, const Layer &layer, const char *id, const char *color) const;
+
+  double m_minX, m_maxY; //!< the left and top of the bounds, the corner of the drawing
+  double m_scale; //!< drawing units per unit of distance
+  double m_width, m_height; //!< the size of the drawing
+  size_t m_budget; //!< most points drawn one by one per layer
+  size_t m_tiles; //!< tiles per side of the grid
+  double m_tileWidth; //!< the side of a tile, in units of distance
+  double m_radius = 0; //!< the radius of the disks
+  Layer m_sites; //!< the sites
+  Layer m_disks; //!< the disk centers
+};
+
+} // namespace ns3
+
+#endif /* UDC_LAYOUT_H */
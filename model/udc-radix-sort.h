@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_RADIX_SORT_H
+#define UDC_RADIX_SORT_H
+
+#include "udc-thread-pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \return an unsigned key that orders like the given double
+ */
+inline uint64_t
+RadixKeyOfDouble (double d)
+{
+  uint64_t bits;
+  std::memcpy (&bits, &d, sizeof bits);
+  return bits >> 63 ? ~bits : bits | (uint64_t (1) << 63);
+}
+
+/**
+ * \ingroup mobility
+ * \brief Stable LSD radix sort of items on a double key.
+ *
+ * The 64-bit keys are sorted 11 bits at a time.  Each pass is split into
+ * one chunk per worker: the chunks count their digits in parallel, the
+ * counts are turned into per-chunk offsets, and the chunks scatter in
+ * parallel, which keeps the sort stable.  A pass in which every key has
+ * the same digit, as in the high bits of clustered coordinates, is skipped.
+ *
+ * \param items the items to sort in place
+ * \param key a functor returning the double key of an item
+ * \param pool the workers to sort with
+ */
+template <typename T, typename KeyOf>
+void
+ParallelRadixSort (std::vector<T> &items, KeyOf key, UdcThreadPool &pool)
+{
+  const int DIGIT_BITS = 11;
+  const size_t RADIX = size_t (1) << DIGIT_BITS;
+  const size_t n = items.size ();
+  if (n < 2)
+    {
+      return;
+    }
+
+  const size_t chunks = std::min<size_t> (pool.GetN (), (n + 4095) / 4096);
+  auto chunkBegin = [n, chunks] (size_t c) { return n * c / chunks; };
+
+  std::vector<uint64_t> keys (n), keysOut (n);
+  std::vector<T> itemsOut (n);
+  pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+    for (size_t i = chunkBegin (c); i < chunkBegin (c + 1); ++i)
+      {
+        keys[i] = RadixKeyOfDouble (key (items[i]));
+      }
+  });
+
+  std::vector<std::vector<size_t>> counts (chunks, std::vector<size_t> (RADIX));
+  for (int shift = 0; shift < 64; shift += DIGIT_BITS)
+    {
+      pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+        std::vector<size_t> &count = counts[c];
+        std::fill (count.begin (), count.end (), 0);
+        for (size_t i = chunkBegin (c); i < chunkBegin (c + 1); ++i)
+          {
+            ++count[(keys[i] >> shift) & (RADIX - 1)];
+          }
+      });
+
+      // Skip the pass if one digit holds every key
+      const size_t firstDigit = (keys[0] >> shift) & (RADIX - 1);
+      size_t sameDigit = 0;
+      for (size_t c = 0; c < chunks; ++c)
+        {
+          sameDigit += counts[c][firstDigit];
+        }
+      if (sameDigit == n)
+        {
+          continue;
+        }
+
+      size_t offset = 0;
+      for (size_t d = 0; d < RADIX; ++d)
+        {
+          for (size_t c = 0; c < chunks; ++c)
+            {
+              const size_t count = counts[c][d];
+              counts[c][d] = offset;
+              offset += count;
+            }
+        }
+
+      pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+        std::vector<size_t> &next = counts[c];
+        for (size_t i = chunkBegin (c); i < chunkBegin (c + 1); ++i)
+          {
+            const size_t to = next[(keys[i] >> shift) & (RADIX - 1)]++;
+            keysOut[to] = keys[i];
+            itemsOut[to] = items[i];
+          }
+      });
+      keys.swap (keysOut);
+      items.swap (itemsOut);
+    }
+}
+
+} // namespace ns3
+
+#endif /* UDC_RADIX_SORT_H */
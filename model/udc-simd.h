@@ -0,0 +1,248 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_SIMD_H
+#define UDC_SIMD_H
+
+#include <cmath>
+#include <cstddef>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define UDC_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief Block kernels for the per-site arithmetic of the cover algorithms.
+ *
+ * Each kernel has a scalar version and, on x86 with GCC or Clang, AVX2
+ * and AVX-512 versions compiled with target attributes, so the module
+ * needs no special compiler flags.  The widest version the CPU supports
+ * is picked at run time.
+ *
+ * The vector versions perform the same IEEE operations as the scalar
+ * ones (a correctly rounded division and floor, and separate multiplies
+ * and adds with no fused multiply-add), so every level returns exactly
+ * the same results.
+ */
+class UdcSimd
+{
+public:
+  enum Level
+  {
+    SCALAR = 0,
+    AVX2,
+    AVX512
+  };
+
+  /**
+   * \return the level the kernels run at
+   */
+  static Level GetLevel (void)
+  {
+    return CurrentLevel ();
+  }
+
+  /**
+   * \brief Run the kernels at the given level, or the best the CPU
+   * supports if that is lower.
+   * \return the level now in effect
+   */
+  static Level SetLevel (Level level)
+  {
+    const Level supported = DetectLevel ();
+    CurrentLevel () = level < supported ? level : supported;
+    return CurrentLevel ();
+  }
+
+  /**
+   * \brief Lattice cell of each coordinate, floor (v[i] / width),
+   * converted to int as the scalar lattice code does.
+   */
+  static void Cells (const double *v, size_t n, double width, int *cells)
+  {
+    size_t i = 0;
+#ifdef UDC_SIMD_X86
+    switch (CurrentLevel ())
+      {
+      case AVX512:
+        i = CellsAvx512 (v, n, width, cells);
+        break;
+      case AVX2:
+        i = CellsAvx2 (v, n, width, cells);
+        break;
+      default:
+        break;
+      }
+#endif
+    for (; i < n; ++i)
+      {
+        cells[i] = std::floor (v[i] / width);
+      }
+  }
+
+  /**
+   * \return true if some (xs[k], ys[k]), k < n, is strictly closer than
+   *         sqrt (radiusSquared) to (x, y)
+   */
+  static bool AnyWithin (const double *xs, const double *ys, size_t n, double x, double y, double radiusSquared)
+  {
+    return FirstWithin (xs, ys, n, x, y, radiusSquared) < n;
+  }
+
+  /**
+   * \return the least k < n such that (xs[k], ys[k]) is strictly closer
+   *         than sqrt (radiusSquared) to (x, y), or n if there is none
+   */
+  static size_t FirstWithin (const double *xs, const double *ys, size_t n, double x, double y, double radiusSquared)
+  {
+    size_t k = 0;
+#ifdef UDC_SIMD_X86
+    switch (CurrentLevel ())
+      {
+      case AVX512:
+        if (FirstWithinAvx512 (xs, ys, n, x, y, radiusSquared, k))
+          {
+            return k;
+          }
+        break;
+      case AVX2:
+        if (FirstWithinAvx2 (xs, ys, n, x, y, radiusSquared, k))
+          {
+            return k;
+          }
+        break;
+      default:
+        break;
+      }
+#endif
+    for (; k < n; ++k)
+      {
+        const double dx = x - xs[k], dy = y - ys[k];
+        const double dx2 = dx * dx, dy2 = dy * dy;
+        if (dx2 + dy2 < radiusSquared)
+          {
+            return k;
+          }
+      }
+    return n;
+  }
+
+private:
+  static Level DetectLevel (void)
+  {
+#ifdef UDC_SIMD_X86
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("avx512f"))
+      {
+        return AVX512;
+      }
+    if (__builtin_cpu_supports ("avx2"))
+      {
+        return AVX2;
+      }
+#endif
+    return SCALAR;
+  }
+
+  static Level &CurrentLevel (void)
+  {
+    static Level level = DetectLevel ();
+    return level;
+  }
+
+#ifdef UDC_SIMD_X86
+  __attribute__ ((target ("avx2"))) static size_t
+  CellsAvx2 (const double *v, size_t n, double width, int *cells)
+  {
+    const __m256d w = _mm256_set1_pd (width);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+      {
+        const __m256d q = _mm256_floor_pd (_mm256_div_pd (_mm256_loadu_pd (v + i), w));
+        _mm_storeu_si128 (reinterpret_cast<__m128i *> (cells + i), _mm256_cvttpd_epi32 (q));
+      }
+    return i;
+  }
+
+  __attribute__ ((target ("avx512f"))) static size_t
+  CellsAvx512 (const double *v, size_t n, double width, int *cells)
+  {
+    const __m512d w = _mm512_set1_pd (width);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+      {
+        // The masked forms keep GCC from warning about their undefined pass-through
+        const __m512d q = _mm512_maskz_roundscale_pd (0xFF, _mm512_div_pd (_mm512_loadu_pd (v + i), w),
+                                                      _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        _mm256_storeu_si256 (reinterpret_cast<__m256i *> (cells + i), _mm512_maskz_cvttpd_epi32 (0xFF, q));
+      }
+    return i;
+  }
+
+  /**
+   * Test whole vectors of disks, leaving in k the first disk within reach,
+   * or else the first disk not tested.
+   */
+  __attribute__ ((target ("avx2"))) static bool
+  FirstWithinAvx2 (const double *xs, const double *ys, size_t n, double x, double y, double radiusSquared, size_t &k)
+  {
+    const __m256d px = _mm256_set1_pd (x), py = _mm256_set1_pd (y), r2 = _mm256_set1_pd (radiusSquared);
+    for (k = 0; k + 4 <= n; k += 4)
+      {
+        const __m256d dx = _mm256_sub_pd (px, _mm256_loadu_pd (xs + k)),
+                      dy = _mm256_sub_pd (py, _mm256_loadu_pd (ys + k));
+        const __m256d d2 = _mm256_add_pd (_mm256_mul_pd (dx, dx), _mm256_mul_pd (dy, dy));
+        const int within = _mm256_movemask_pd (_mm256_cmp_pd (d2, r2, _CMP_LT_OQ));
+        if (within)
+          {
+            k += __builtin_ctz (within);
+            return true;
+          }
+      }
+    return false;
+  }
+
+  __attribute__ ((target ("avx512f"))) static bool
+  FirstWithinAvx512 (const double *xs, const double *ys, size_t n, double x, double y, double radiusSquared, size_t &k)
+  {
+    const __m512d px = _mm512_set1_pd (x), py = _mm512_set1_pd (y), r2 = _mm512_set1_pd (radiusSquared);
+    for (k = 0; k + 8 <= n; k += 8)
+      {
+        const __m512d dx = _mm512_sub_pd (px, _mm512_loadu_pd (xs + k)),
+                      dy = _mm512_sub_pd (py, _mm512_loadu_pd (ys + k));
+        const __m512d d2 = _mm512_add_pd (_mm512_mul_pd (dx, dx), _mm512_mul_pd (dy, dy));
+        const __mmask8 within = _mm512_cmp_pd_mask (d2, r2, _CMP_LT_OQ);
+        if (within)
+          {
+            k += __builtin_ctz (within);
+            return true;
+          }
+      }
+    return false;
+  }
+#endif
+};
+
+} // namespace ns3
+
+#endif /* UDC_SIMD_H */
@@ -0,0 +1,521 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#include "udc-site-store.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+static const char SITE_FILE_MAGIC[8] = {'U', 'D', 'C', 'S', 'I', 'T', 'E', '1'};
+static const size_t SITE_FILE_HEADER = 16;
+
+/*
+ * Read exactly bytes at offset, retrying short reads.
+ */
+static bool
+ReadAt (int fd, void *buffer, size_t bytes, uint64_t offset)
+{
+  char *p = static_cast<char *> (buffer);
+  while (bytes > 0)
+    {
+      const ssize_t got = pread (fd, p, bytes, offset);
+      if (got <= 0)
+        {
+          return false;
+        }
+      p += got;
+      bytes -= got;
+      offset += got;
+    }
+  return true;
+}
+
+/*
+ * Write all of buffer at the current offset, retrying short writes.
+ */
+static bool
+WriteAll (int fd, const void *buffer, size_t bytes)
+{
+  const char *p = static_cast<const char *> (buffer);
+  while (bytes > 0)
+    {
+      const ssize_t put = write (fd, p, bytes);
+      if (put <= 0)
+        {
+          return false;
+        }
+      p += put;
+      bytes -= put;
+    }
+  return true;
+}
+
+/*
+ * The step nearest to offset, clamped to the range of a uint32_t.
+ */
+static uint32_t
+Quantize (double offset, double step)
+{
+  return uint32_t (std::min<double> (std::max (std::round (offset / step), 0.0), UINT32_MAX));
+}
+
+/*
+ * The error of each coordinate encoded at a precision over a bounding box.
+ */
+static double
+GetAxisError (UdcSiteStore::Precision precision, double minX, double minY, double maxX, double maxY)
+{
+  // Rounding in the double arithmetic of encoding and decoding
+  const double magnitude = std::max ({std::fabs (minX), std::fabs (maxX), std::fabs (minY), std::fabs (maxY)});
+  const double span = std::max (maxX - minX, maxY - minY);
+  const double arithmetic = std::ldexp (magnitude + span, -51);
+  switch (precision)
+    {
+    case UdcSiteStore::FLOAT:
+      // A float rounds to within 2^-24 of its magnitude, at most half the span
+      return std::ldexp (span / 2, -24) + arithmetic;
+    case UdcSiteStore::QUANTIZED:
+      // Rounding to the nearest step
+      return (span > 0 ? span / UINT32_MAX : 1) / 2 + arithmetic;
+    default:
+      return 0;
+    }
+}
+
+double
+UdcSiteStore::GetCompactError (Precision precision, double minX, double minY, double maxX, double maxY)
+{
+  return std::sqrt (2.0) * GetAxisError (precision, minX, minY, maxX, maxY);
+}
+
+void
+UdcSiteStore::Compact (Precision precision, double minX, double minY, double maxX, double maxY)
+{
+  if (precision == DOUBLE && !m_tailX.empty ())
+    {
+      MakeOwned ();
+    }
+  if (precision == DOUBLE || (precision == m_precision && m_tailX.empty ()))
+    {
+      return;
+    }
+
+  const double spanX = maxX - minX, spanY = maxY - minY;
+  const double error = GetAxisError (precision, minX, minY, maxX, maxY);
+
+  const size_t n = GetN ();
+  if (precision == FLOAT)
+    {
+      const double originX = minX + spanX / 2, originY = minY + spanY / 2;
+      std::vector<float> fx (n), fy (n);
+      for (size_t i = 0; i < n; ++i)
+        {
+          fx[i] = float (X (i) - originX);
+          fy[i] = float (Y (i) - originY);
+        }
+      const double maxError = m_maxError;
+      Clear ();
+      m_fx.swap (fx);
+      m_fy.swap (fy);
+      m_originX = originX;
+      m_originY = originY;
+      m_maxError = maxError;
+    }
+  else
+    {
+      const double stepX = spanX > 0 ? spanX / UINT32_MAX : 1, stepY = spanY > 0 ? spanY / UINT32_MAX : 1;
+      std::vector<uint32_t> qx (n), qy (n);
+      for (size_t i = 0; i < n; ++i)
+        {
+          qx[i] = Quantize (X (i) - minX, stepX);
+          qy[i] = Quantize (Y (i) - minY, stepY);
+        }
+      const double maxError = m_maxError;
+      Clear ();
+      m_qx.swap (qx);
+      m_qy.swap (qy);
+      m_originX = minX;
+      m_originY = minY;
+      m_stepX = stepX;
+      m_stepY = stepY;
+      m_maxError = maxError;
+    }
+  OwnCompact ();
+  m_precision = precision;
+  m_n = n;
+  m_x = m_y = nullptr;
+  m_axisError = error;
+  m_maxError += std::sqrt (2.0) * error;
+}
+
+bool
+UdcSiteStore::Overwrite (size_t i, double x, double y)
+{
+  switch (m_precision)
+    {
+    case FLOAT:
+      {
+        const float fx = float (x - m_originX), fy = float (y - m_originY);
+        if (m_floatX != m_fx.data () || !(std::fabs (m_originX + fx - x) <= m_axisError)
+            || !(std::fabs (m_originY + fy - y) <= m_axisError))
+          {
+            return false;
+          }
+        m_fx[i] = fx;
+        m_fy[i] = fy;
+        return true;
+      }
+    case QUANTIZED:
+      {
+        const uint32_t qx = Quantize (x - m_originX, m_stepX), qy = Quantize (y - m_originY, m_stepY);
+        if (m_quantX != m_qx.data () || !(std::fabs (m_originX + qx * m_stepX - x) <= m_axisError)
+            || !(std::fabs (m_originY + qy * m_stepY - y) <= m_axisError))
+          {
+            return false;
+          }
+        m_qx[i] = qx;
+        m_qy[i] = qy;
+        return true;
+      }
+    default:
+      if (m_x != m_ownedX.data ())
+        {
+          return false;
+        }
+      m_ownedX[i] = x;
+      m_ownedY[i] = y;
+      return true;
+    }
+}
+
+void
+UdcSiteStore::SwapRemove (size_t i)
+{
+  if (i >= m_n)
+    {
+      m_tailX[i - m_n] = m_tailX.back ();
+      m_tailY[i - m_n] = m_tailY.back ();
+      m_tailX.pop_back ();
+      m_tailY.pop_back ();
+      return;
+    }
+  if (!m_tailX.empty ())
+    {
+      // The last site is in the tail, and moves into the store proper
+      if (!Overwrite (i, m_tailX.back (), m_tailY.back ()))
+        {
+          MakeOwned ();
+          SwapRemove (i);
+          return;
+        }
+      m_tailX.pop_back ();
+      m_tailY.pop_back ();
+      return;
+    }
+
+  // The last site is in the store proper, and moves as stored
+  switch (m_precision)
+    {
+    case FLOAT:
+      if (m_floatX == m_fx.data ())
+        {
+          m_fx[i] = m_fx.back ();
+          m_fy[i] = m_fy.back ();
+          m_fx.pop_back ();
+          m_fy.pop_back ();
+          OwnCompact ();
+          --m_n;
+          return;
+        }
+      break;
+    case QUANTIZED:
+      if (m_quantX == m_qx.data ())
+        {
+          m_qx[i] = m_qx.back ();
+          m_qy[i] = m_qy.back ();
+          m_qx.pop_back ();
+          m_qy.pop_back ();
+          OwnCompact ();
+          --m_n;
+          return;
+        }
+      break;
+    default:
+      break;
+    }
+  MakeOwned ();
+  m_ownedX[i] = m_ownedX.back ();
+  m_ownedY[i] = m_ownedY.back ();
+  m_ownedX.pop_back ();
+  m_ownedY.pop_back ();
+  Own ();
+}
+
+void
+UdcSiteStore::Gather (const UdcSiteStore &from, const std::vector<uint32_t> &order, UdcThreadPool &pool)
+{
+  Clear ();
+  const size_t n = order.size ();
+  switch (from.m_precision)
+    {
+    case FLOAT:
+      m_fx.resize (n);
+      m_fy.resize (n);
+      break;
+    case QUANTIZED:
+      m_qx.resize (n);
+      m_qy.resize (n);
+      break;
+    default:
+      m_ownedX.resize (n);
+      m_ownedY.resize (n);
+      break;
+    }
+
+  const size_t chunks = std::min<size_t> (pool.GetN (), (n + 65535) / 65536);
+  pool.ParallelFor (chunks, [&] (size_t c, unsigned) {
+    for (size_t k = n * c / chunks; k < n * (c + 1) / chunks; ++k)
+      {
+        const uint32_t i = order[k];
+        switch (from.m_precision)
+          {
+          case FLOAT:
+            m_fx[k] = from.m_floatX[i];
+            m_fy[k] = from.m_floatY[i];
+            break;
+          case QUANTIZED:
+            m_qx[k] = from.m_quantX[i];
+            m_qy[k] = from.m_quantY[i];
+            break;
+          default:
+            m_ownedX[k] = from.m_x[i];
+            m_ownedY[k] = from.m_y[i];
+            break;
+          }
+      }
+  });
+
+  Own ();
+  OwnCompact ();
+  m_n = n;
+  m_precision = from.m_precision;
+  m_maxError = from.m_maxError;
+  m_originX = from.m_originX;
+  m_originY = from.m_originY;
+  m_stepX = from.m_stepX;
+  m_stepY = from.m_stepY;
+  m_axisError = from.m_axisError;
+}
+
+bool
+UdcSiteStore::MapFile (const std::string &filename)
+{
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      return false;
+    }
+  struct stat st;
+  if (fstat (fd, &st) != 0 || size_t (st.st_size) < SITE_FILE_HEADER)
+    {
+      close (fd);
+      return false;
+    }
+  const size_t size = st.st_size;
+  void *base = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (base == MAP_FAILED)
+    {
+      return false;
+    }
+  std::shared_ptr<const void> mapping (base, [size] (const void *p) {
+    munmap (const_cast<void *> (p), size);
+  });
+
+  const char *bytes = static_cast<const char *> (base);
+  uint64_t n;
+  std::memcpy (&n, bytes + 8, sizeof n);
+  if (std::memcmp (bytes, SITE_FILE_MAGIC, sizeof SITE_FILE_MAGIC) != 0
+      || n != (size - SITE_FILE_HEADER) / (2 * sizeof (double))
+      || SITE_FILE_HEADER + 2 * sizeof (double) * n != size)
+    {
+      return false;
+    }
+  madvise (base, size, MADV_SEQUENTIAL);
+
+  const double *x = reinterpret_cast<const double *> (bytes + SITE_FILE_HEADER);
+  Borrow (x, x + n, n, mapping);
+  return true;
+}
+
+bool
+UdcSiteStore::WriteFile (const std::string &filename, const double *x, const double *y, size_t n)
+{
+  std::ofstream out (filename, std::ios::binary | std::ios::trunc);
+  const uint64_t count = n;
+  out.write (SITE_FILE_MAGIC, sizeof SITE_FILE_MAGIC);
+  out.write (reinterpret_cast<const char *> (&count), sizeof count);
+  out.write (reinterpret_cast<const char *> (x), n * sizeof (double));
+  out.write (reinterpret_cast<const char *> (y), n * sizeof (double));
+  return bool (out.flush ());
+}
+
+UdcSiteFileReader::~UdcSiteFileReader ()
+{
+  if (m_fd >= 0)
+    {
+      close (m_fd);
+    }
+}
+
+bool
+UdcSiteFileReader::Open (const std::string &filename)
+{
+  if (m_fd >= 0)
+    {
+      close (m_fd);
+    }
+  m_n = m_next = 0;
+  m_fd = open (filename.c_str (), O_RDONLY);
+  if (m_fd < 0)
+    {
+      return false;
+    }
+  struct stat st;
+  char header[SITE_FILE_HEADER];
+  uint64_t n = 0;
+  if (fstat (m_fd, &st) != 0 || size_t (st.st_size) < SITE_FILE_HEADER
+      || !ReadAt (m_fd, header, sizeof header, 0))
+    {
+      close (m_fd);
+      m_fd = -1;
+      return false;
+    }
+  std::memcpy (&n, header + 8, sizeof n);
+  const uint64_t size = st.st_size;
+  if (std::memcmp (header, SITE_FILE_MAGIC, sizeof SITE_FILE_MAGIC) != 0
+      || n != (size - SITE_FILE_HEADER) / (2 * sizeof (double))
+      || SITE_FILE_HEADER + 2 * sizeof (double) * n != size)
+    {
+      close (m_fd);
+      m_fd = -1;
+      return false;
+    }
+  posix_fadvise (m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  m_n = n;
+  return true;
+}
+
+size_t
+UdcSiteFileReader::Read (double *x, double *y, size_t count)
+{
+  count = std::min<uint64_t> (count, m_n - m_next);
+  if (m_fd < 0 || count == 0)
+    {
+      return 0;
+    }
+  const uint64_t xOffset = SITE_FILE_HEADER + sizeof (double) * m_next;
+  if (!ReadAt (m_fd, x, count * sizeof (double), xOffset)
+      || !ReadAt (m_fd, y, count * sizeof (double), xOffset + sizeof (double) * m_n))
+    {
+      return 0;
+    }
+  m_next += count;
+  return count;
+}
+
+UdcSiteFileWriter::~UdcSiteFileWriter ()
+{
+  if (m_fd >= 0)
+    {
+      Close ();
+    }
+}
+
+bool
+UdcSiteFileWriter::Open (const std::string &filename)
+{
+  m_n = 0;
+  m_ok = true;
+  m_x.clear ();
+  m_y.clear ();
+  m_yName = filename + ".y";
+  m_fd = open (filename.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  m_yFd = open (m_yName.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (m_fd < 0 || m_yFd < 0)
+    {
+      m_ok = false;
+      Close ();
+      return false;
+    }
+  char header[SITE_FILE_HEADER] = {};
+  std::memcpy (header, SITE_FILE_MAGIC, sizeof SITE_FILE_MAGIC);
+  m_ok = WriteAll (m_fd, header, sizeof header);
+  return m_ok;
+}
+
+void
+UdcSiteFileWriter::Flush (void)
+{
+  m_ok = m_ok && WriteAll (m_fd, m_x.data (), m_x.size () * sizeof (double))
+         && WriteAll (m_yFd, m_y.data (), m_y.size () * sizeof (double));
+  m_x.clear ();
+  m_y.clear ();
+}
+
+bool
+UdcSiteFileWriter::Close (void)
+{
+  if (m_fd >= 0 && m_yFd >= 0)
+    {
+      Flush ();
+
+      // Append the y, then fill in the count
+      std::vector<char> buffer (size_t (1) << 20);
+      const uint64_t bytes = m_n * sizeof (double);
+      for (uint64_t done = 0; m_ok && done < bytes; done += buffer.size ())
+        {
+          const size_t chunk = std::min<uint64_t> (buffer.size (), bytes - done);
+          m_ok = ReadAt (m_yFd, buffer.data (), chunk, done) && WriteAll (m_fd, buffer.data (), chunk);
+        }
+      m_ok = m_ok && pwrite (m_fd, &m_n, sizeof m_n, 8) == sizeof m_n;
+    }
+  if (m_fd >= 0)
+    {
+      m_ok = close (m_fd) == 0 && m_ok;
+    }
+  if (m_yFd >= 0)
+    {
+      close (m_yFd);
+      unlink (m_yName.c_str ());
+    }
+  m_fd = m_yFd = -1;
+  return m_ok;
+}
+
+} // namespace ns3
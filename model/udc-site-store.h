@@ -0,0 +1,495 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_SITE_STORE_H
+#define UDC_SITE_STORE_H
+
+#include "udc-thread-pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief The sites to cover, as separate arrays of x and y.
+ *
+ * The arrays are either owned by the store or borrowed from the caller
+ * (a buffer or a memory-mapped site file), in which case nothing is
+ * copied.  Sites appended to a borrowed or compacted store are kept
+ * apart, as doubles, in a tail after the others, so appending never
+ * copies the store.  Removing a site overwrites it with the last site,
+ * which copies a borrowed store once, and a compacted one only if the
+ * last site cannot be stored at its precision within its error bound.
+ *
+ * A store can be compacted to single precision or to 32-bit fixed point,
+ * halving its size.  The coordinates read back then differ from the ones
+ * given by at most GetMaxError (), which callers must subtract from the
+ * radius for the disks they place to cover the original sites.
+ */
+class UdcSiteStore
+{
+public:
+  /**
+   * How the coordinates are held
+   */
+  enum Precision
+  {
+    DOUBLE = 0, //!< 8-byte doubles, exact
+    FLOAT,      //!< 4-byte floats relative to the center of the sites
+    QUANTIZED   //!< 4-byte fixed point over the bounding box of the sites
+  };
+
+  UdcSiteStore ()
+    : m_precision (DOUBLE),
+      m_x (nullptr),
+      m_y (nullptr),
+      m_n (0),
+      m_maxError (0)
+  {
+  }
+
+  /**
+   * \brief Take ownership of the given coordinates.
+   */
+  void Assign (std::vector<double> &&x, std::vector<double> &&y)
+  {
+    Clear ();
+    m_ownedX.swap (x);
+    m_ownedY.swap (y);
+    Own ();
+  }
+
+  /**
+   * \brief Use the caller's coordinates in place.
+   * \param x,y arrays of n coordinates, which must outlive the store
+   *        unless keepAlive holds them
+   * \param n the number of sites
+   * \param keepAlive an owner of the arrays, released with the store
+   */
+  void Borrow (const double *x, const double *y, size_t n, std::shared_ptr<const void> keepAlive = nullptr)
+  {
+    Clear ();
+    m_keepAlive = std::move (keepAlive);
+    m_x = x;
+    m_y = y;
+    m_n = n;
+  }
+
+  /**
+   * \brief Drop every site, releasing any borrowed arrays.
+   */
+  void Clear (void)
+  {
+    m_precision = DOUBLE;
+    m_maxError = 0;
+    m_keepAlive.reset ();
+    std::vector<double> ().swap (m_ownedX);
+    std::vector<double> ().swap (m_ownedY);
+    std::vector<float> ().swap (m_fx);
+    std::vector<float> ().swap (m_fy);
+    std::vector<uint32_t> ().swap (m_qx);
+    std::vector<uint32_t> ().swap (m_qy);
+    std::vector<double> ().swap (m_tailX);
+    std::vector<double> ().swap (m_tailY);
+    m_x = m_y = nullptr;
+    m_floatX = m_floatY = nullptr;
+    m_quantX = m_quantY = nullptr;
+    m_n = 0;
+  }
+
+  /**
+   * \brief Use the sites of another store in place, at its precision.
+   *
+   * Nothing is copied but the tail, so the other store must outlive this
+   * one and stay unchanged while this one is used.
+   */
+  void Share (const UdcSiteStore &from)
+  {
+    Clear ();
+    m_precision = from.m_precision;
+    m_x = from.m_x;
+    m_y = from.m_y;
+    m_floatX = from.m_floatX;
+    m_floatY = from.m_floatY;
+    m_quantX = from.m_quantX;
+    m_quantY = from.m_quantY;
+    m_n = from.m_n;
+    m_maxError = from.m_maxError;
+    m_originX = from.m_originX;
+    m_originY = from.m_originY;
+    m_stepX = from.m_stepX;
+    m_stepY = from.m_stepY;
+    m_axisError = from.m_axisError;
+    m_tailX = from.m_tailX;
+    m_tailY = from.m_tailY;
+  }
+
+
+  /**
+   * \brief Re-encode the sites at a lower precision, releasing the
+   * doubles (or the borrowed buffers) they were held in.
+   *
+   * The sites of the tail are encoded with the rest.
+   *
+   * \param precision the new precision; DOUBLE leaves the store as it
+   *        is, unless it has a tail, when every site is copied to owned
+   *        doubles
+   * \param minX,minY,maxX,maxY the bounding box of the sites
+   */
+  void Compact (Precision precision, double minX, double minY, double maxX, double maxY);
+
+  /**
+   * \return the error Compact adds to GetMaxError, storing sites within
+   *         the given bounding box at the given precision; it grows with
+   *         the size of the box
+   */
+  static double GetCompactError (Precision precision, double minX, double minY, double maxX, double maxY);
+
+  /**
+   * \brief Fill this store with the sites of another, in the given order,
+   * copying the stored values without re-encoding them.
+   *
+   * The other store must have no tail; Compact it first if it has.
+   */
+  void Gather (const UdcSiteStore &from, const std::vector<uint32_t> &order, UdcThreadPool &pool);
+
+  Precision GetPrecision (void) const
+  {
+    return m_precision;
+  }
+
+  /**
+   * \return an upper bound on the distance between a site as read back
+   *         and the site as given
+   */
+  double GetMaxError (void) const
+  {
+    return m_maxError;
+  }
+
+  /**
+   * \return the bytes of coordinates held or borrowed
+   */
+  size_t GetBytes (void) const
+  {
+    return m_n * (m_precision == DOUBLE ? 2 * sizeof (double) : 2 * sizeof (float))
+           + m_tailX.size () * 2 * sizeof (double);
+  }
+
+  size_t GetN (void) const
+  {
+    return m_n + m_tailX.size ();
+  }
+
+  bool IsEmpty (void) const
+  {
+    return GetN () == 0;
+  }
+
+  /**
+   * \return true if some sites appended to a borrowed or compacted store
+   *         are held apart, as doubles
+   */
+  bool HasTail (void) const
+  {
+    return !m_tailX.empty ();
+  }
+
+  double X (size_t i) const
+  {
+    if (i >= m_n)
+      {
+        return m_tailX[i - m_n];
+      }
+    switch (m_precision)
+      {
+      case FLOAT:
+        return m_originX + m_floatX[i];
+      case QUANTIZED:
+        return m_originX + m_quantX[i] * m_stepX;
+      default:
+        return m_x[i];
+      }
+  }
+
+  double Y (size_t i) const
+  {
+    if (i >= m_n)
+      {
+        return m_tailY[i - m_n];
+      }
+    switch (m_precision)
+      {
+      case FLOAT:
+        return m_originY + m_floatY[i];
+      case QUANTIZED:
+        return m_originY + m_quantY[i] * m_stepY;
+      default:
+        return m_y[i];
+      }
+  }
+
+  /**
+   * \brief Decode the sites [begin, begin + count) into x and y.
+   */
+  void Decode (size_t begin, size_t count, double *x, double *y) const
+  {
+    // The part before the tail, then the part in it
+    const size_t base = begin < m_n ? std::min (count, m_n - begin) : 0;
+    switch (m_precision)
+      {
+      case FLOAT:
+        for (size_t k = 0; k < base; ++k)
+          {
+            x[k] = m_originX + m_floatX[begin + k];
+            y[k] = m_originY + m_floatY[begin + k];
+          }
+        break;
+      case QUANTIZED:
+        for (size_t k = 0; k < base; ++k)
+          {
+            x[k] = m_originX + m_quantX[begin + k] * m_stepX;
+            y[k] = m_originY + m_quantY[begin + k] * m_stepY;
+          }
+        break;
+      default:
+        std::copy (m_x + begin, m_x + begin + base, x);
+        std::copy (m_y + begin, m_y + begin + base, y);
+        break;
+      }
+    if (base < count)
+      {
+        const size_t tail = begin + base - m_n;
+        std::copy (m_tailX.begin () + tail, m_tailX.begin () + tail + (count - base), x + base);
+        std::copy (m_tailY.begin () + tail, m_tailY.begin () + tail + (count - base), y + base);
+      }
+  }
+
+  /**
+   * \brief Append a site, in amortized constant time.
+   *
+   * The site goes at the end of an owned store of doubles, and in the tail
+   * of any other, exactly as given.
+   */
+  void Push (double x, double y)
+  {
+    if (m_tailX.empty () && m_precision == DOUBLE && m_x == m_ownedX.data ())
+      {
+        m_ownedX.push_back (x);
+        m_ownedY.push_back (y);
+        Own ();
+      }
+    else
+      {
+        m_tailX.push_back (x);
+        m_tailY.push_back (y);
+      }
+  }
+
+  /**
+   * \brief Overwrite site i with the last site and drop the last site.
+   *
+   * This takes constant time, but for copying a borrowed store when a
+   * site of it is removed, and a compacted store when the last site is in
+   * the tail and cannot be encoded within the error bound of the store.
+   */
+  void SwapRemove (size_t i);
+
+  /**
+   * \brief Map a binary site file and borrow its coordinates.
+   *
+   * The file holds the 8 bytes "UDCSITE1", the number of sites n as a
+   * uint64, then n doubles of x and n doubles of y, all in host byte
+   * order.
+   *
+   * \param filename the file to map
+   * \return false, leaving the store unchanged, if the file cannot be
+   *         mapped or is not a complete site file
+   */
+  bool MapFile (const std::string &filename);
+
+  /**
+   * \brief Write sites in the format read by MapFile.
+   * \return false if the file could not be written
+   */
+  static bool WriteFile (const std::string &filename, const double *x, const double *y, size_t n);
+
+private:
+  /**
+   * Hold every site as owned doubles, moving the tail in after the rest
+   */
+  void MakeOwned (void)
+  {
+    if (m_precision != DOUBLE || m_x != m_ownedX.data () || !m_tailX.empty ())
+      {
+        const size_t n = GetN ();
+        std::vector<double> x (n), y (n);
+        for (size_t i = 0; i < n; ++i)
+          {
+            x[i] = X (i);
+            y[i] = Y (i);
+          }
+        const double maxError = m_maxError;
+        Assign (std::move (x), std::move (y));
+        m_maxError = maxError;
+      }
+  }
+
+  void Own (void)
+  {
+    m_x = m_ownedX.data ();
+    m_y = m_ownedY.data ();
+    m_n = m_ownedX.size ();
+  }
+
+  /**
+   * Set site i, which is not in the tail, to (x, y), if the store owns its
+   * coordinates and (x, y) reads back within the per-coordinate error of
+   * the store
+   */
+  bool Overwrite (size_t i, double x, double y);
+
+  void OwnCompact (void)
+  {
+    m_floatX = m_fx.data ();
+    m_floatY = m_fy.data ();
+    m_quantX = m_qx.data ();
+    m_quantY = m_qy.data ();
+  }
+
+  Precision m_precision;
+  const double *m_x; //!< DOUBLE: the x of every site, owned or borrowed
+  const double *m_y; //!< DOUBLE: the y of every site, owned or borrowed
+  size_t m_n;        //!< the number of sites
+  double m_maxError; //!< bound on the distance from a stored site to the given one
+  std::vector<double> m_ownedX, m_ownedY;
+  std::shared_ptr<const void> m_keepAlive; //!< owner of borrowed arrays, if any
+  double m_originX = 0, m_originY = 0;     //!< FLOAT, QUANTIZED: offset added back
+  double m_stepX = 0, m_stepY = 0;         //!< QUANTIZED: size of one step
+  double m_axisError = 0;                  //!< FLOAT, QUANTIZED: bound on the error of each coordinate encoded
+  std::vector<float> m_fx, m_fy;           //!< FLOAT: coordinates less the origin, if owned
+  std::vector<uint32_t> m_qx, m_qy;        //!< QUANTIZED: steps above the origin, if owned
+  const float *m_floatX = nullptr, *m_floatY = nullptr;     //!< FLOAT: the coordinates, owned or shared
+  const uint32_t *m_quantX = nullptr, *m_quantY = nullptr;  //!< QUANTIZED: the coordinates, owned or shared
+  std::vector<double> m_tailX, m_tailY;    //!< sites m_n and on, appended to a borrowed or compacted store
+};
+
+/**
+ * \ingroup mobility
+ * \brief Sequential reader of a site file, for files too large to map.
+ *
+ * The sites are read in order, a buffer at a time, from the x and the y
+ * halves of the file.
+ */
+class UdcSiteFileReader
+{
+public:
+  UdcSiteFileReader () = default;
+  ~UdcSiteFileReader ();
+  UdcSiteFileReader (const UdcSiteFileReader &) = delete;
+  UdcSiteFileReader &operator= (const UdcSiteFileReader &) = delete;
+
+  /**
+   * \param filename a file in the format of UdcSiteStore::MapFile
+   * \return false if the file cannot be opened or is not a complete site file
+   */
+  bool Open (const std::string &filename);
+
+  uint64_t GetN (void) const
+  {
+    return m_n;
+  }
+
+  /**
+   * \brief Read the next sites into x and y.
+   * \param count the most sites to read
+   * \return the number of sites read, 0 at the end of the file or on error
+   */
+  size_t Read (double *x, double *y, size_t count);
+
+private:
+  int m_fd = -1;
+  uint64_t m_n = 0;    //!< sites in the file
+  uint64_t m_next = 0; //!< the next site to read
+};
+
+/**
+ * \ingroup mobility
+ * \brief Writes a site file one site at a time, in bounded memory.
+ *
+ * The x are written to the file as they come and the y to a temporary
+ * file beside it, which Close appends to the file before filling in the
+ * number of sites.
+ */
+class UdcSiteFileWriter
+{
+public:
+  UdcSiteFileWriter () = default;
+  ~UdcSiteFileWriter ();
+  UdcSiteFileWriter (const UdcSiteFileWriter &) = delete;
+  UdcSiteFileWriter &operator= (const UdcSiteFileWriter &) = delete;
+
+  /**
+   * \return false if the file or its temporary file cannot be created
+   */
+  bool Open (const std::string &filename);
+
+  void Push (double x, double y)
+  {
+    m_x.push_back (x);
+    m_y.push_back (y);
+    ++m_n;
+    if (m_x.size () == BUFFER_SITES)
+      {
+        Flush ();
+      }
+  }
+
+  uint64_t GetN (void) const
+  {
+    return m_n;
+  }
+
+  /**
+   * \brief Complete the file and remove the temporary file.
+   * \return false if any write failed
+   */
+  bool Close (void);
+
+private:
+  static const size_t BUFFER_SITES = 1 << 16;
+
+  void Flush (void);
+
+  int m_fd = -1, m_yFd = -1;
+  std::string m_yName; //!< the temporary file of the y
+  uint64_t m_n = 0;
+  bool m_ok = true;    //!< no write has failed
+  std::vector<double> m_x, m_y; //!< sites not yet written
+};
+
+} // namespace ns3
+
+#endif /* UDC_SITE_STORE_H */
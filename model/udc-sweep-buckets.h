@@ -0,0 +1,210 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_SWEEP_BUCKETS_H
+#define UDC_SWEEP_BUCKETS_H
+
+#include "udc-simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief Active disks of a left-to-right sweep, bucketed by y.
+ *
+ * The disks are kept in horizontal bands at least one radius tall, each
+ * band holding the x and y of its disks in two flat arrays in insertion
+ * order.  A disk within one radius of a site must lie in the site's band
+ * or one of the two next to it, so a query touches three bands.  Disks
+ * are inserted and queried in nondecreasing x, so a queue of the bands of
+ * the disks in the order they were inserted is also in x order, and each
+ * query drops the disks that fell behind the sweep line from the front of
+ * it, whichever band they are in.  The disks held are those within one
+ * radius behind the sweep line, and a few per band not yet compacted.
+ */
+class YBucketActiveSet
+{
+public:
+  /**
+   * \param minY,maxY the range of y of every disk and query
+   * \param radius the disk radius
+   * \param maxBuckets an upper bound on the number of bands
+   */
+  YBucketActiveSet (double minY, double maxY, double radius, size_t maxBuckets)
+    : m_minY (minY),
+      m_radius (radius),
+      m_radiusSquared (radius * radius)
+  {
+    const double span = std::max (maxY - minY, 0.0);
+    const size_t wanted = std::max<size_t> (1, std::min<size_t> (maxBuckets, 1 << 20));
+    m_width = std::max (radius, span / wanted);
+    m_buckets.resize (std::min<double> (wanted, std::floor (span / m_width) + 1));
+  }
+
+  /**
+   * \brief Add a disk centered at (x, y); x must not decrease between calls.
+   */
+  void Insert (double x, double y)
+  {
+    Advance (x);
+    const size_t bucket = BucketOf (y);
+    Bucket &b = m_buckets[bucket];
+    b.xs.push_back (x);
+    b.ys.push_back (y);
+    b.disks.push_back (m_inserted++);
+    m_queue.push_back (bucket);
+    ++m_held;
+  }
+
+  /**
+   * \return true if some active disk is strictly closer than one radius
+   *         to (x, y); x must not decrease between calls
+   */
+  bool Covers (double x, double y)
+  {
+    return Covering (x, y) >= 0;
+  }
+
+  /**
+   * \return the number, counting Insert calls from 0, of an active disk
+   *         strictly closer than one radius to (x, y), or -1 if there is
+   *         none; x must not decrease between calls
+   */
+  int64_t Covering (double x, double y)
+  {
+    Advance (x);
+    const size_t center = BucketOf (y);
+    const size_t first = center == 0 ? 0 : center - 1,
+                 last = std::min (center + 1, m_buckets.size () - 1);
+    for (size_t i = first; i <= last; ++i)
+      {
+        const Bucket &b = m_buckets[i];
+        const size_t active = b.xs.size () - b.head;
+        const size_t k = UdcSimd::FirstWithin (b.xs.data () + b.head, b.ys.data () + b.head, active,
+                                               x, y, m_radiusSquared);
+        if (k < active)
+          {
+            return b.disks[b.head + k];
+          }
+      }
+    return -1;
+  }
+
+  /**
+   * \return the bytes of the bands, including disks already expired
+   */
+  size_t GetBytes (void) const
+  {
+    size_t bytes = m_buckets.capacity () * sizeof (Bucket);
+    for (const Bucket &b : m_buckets)
+      {
+        bytes += (b.xs.capacity () + b.ys.capacity ()) * sizeof (double) + b.disks.capacity () * sizeof (uint32_t);
+      }
+    return bytes + m_queue.capacity () * sizeof (uint32_t);
+  }
+
+  /**
+   * \return about the bytes the bands and the queue hold now, in constant
+   *         time; the sweep of a site file keeps this under its budget
+   */
+  size_t GetHeldBytes (void) const
+  {
+    return m_buckets.size () * GetBucketBytes () + m_held * DISK_BYTES
+           + (m_queue.size () - m_queueHead) * sizeof (uint32_t);
+  }
+
+  /**
+   * \return the bytes a band takes with nothing active in it, which bounds
+   *         the number of bands worth having in a budget
+   */
+  static size_t GetBucketBytes (void)
+  {
+    return sizeof (Bucket) + COMPACT_AFTER * DISK_BYTES;
+  }
+
+private:
+  struct Bucket
+  {
+    std::vector<double> xs, ys;
+    std::vector<uint32_t> disks; //!< the number of each disk
+    size_t head = 0; //!< first disk not yet behind the sweep line
+  };
+
+  // The bytes of one disk in a band, and the dead disks a band keeps
+  // before it is compacted
+  static const size_t DISK_BYTES = 2 * sizeof (double) + sizeof (uint32_t);
+  static const size_t COMPACT_AFTER = 32;
+
+  size_t BucketOf (double y) const
+  {
+    const double b = std::floor ((y - m_minY) / m_width);
+    return b <= 0 ? 0 : std::min<size_t> (b, m_buckets.size () - 1);
+  }
+
+  /**
+   * Drop every disk whose right edge is left of x, oldest first, compacting
+   * a band once half of it is dead, and the queue likewise.
+   */
+  void Advance (double x)
+  {
+    while (m_queueHead < m_queue.size ())
+      {
+        Bucket &b = m_buckets[m_queue[m_queueHead]];
+        if (!(b.xs[b.head] + m_radius < x))
+          {
+            break;
+          }
+        ++b.head;
+        ++m_queueHead;
+        if (b.head > COMPACT_AFTER && b.head * 2 > b.xs.size ())
+          {
+            b.xs.erase (b.xs.begin (), b.xs.begin () + b.head);
+            b.ys.erase (b.ys.begin (), b.ys.begin () + b.head);
+            b.disks.erase (b.disks.begin (), b.disks.begin () + b.head);
+            m_held -= b.head;
+            b.head = 0;
+          }
+      }
+    if (m_queueHead > COMPACT_AFTER && m_queueHead * 2 > m_queue.size ())
+      {
+        m_queue.erase (m_queue.begin (), m_queue.begin () + m_queueHead);
+        m_queueHead = 0;
+      }
+  }
+
+  double m_minY;
+  double m_radius;
+  double m_radiusSquared;
+  double m_width; //!< band height, never less than the radius
+  std::vector<Bucket> m_buckets;
+  std::vector<uint32_t> m_queue; //!< the band of every disk not yet dropped, in insertion order
+  size_t m_queueHead = 0; //!< first entry of m_queue not yet dropped
+  size_t m_held = 0; //!< disks in the bands, dropped or not, until compacted
+  uint32_t m_inserted = 0;
+};
+
+} // namespace ns3
+
+#endif /* UDC_SWEEP_BUCKETS_H */
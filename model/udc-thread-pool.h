@@ -0,0 +1,295 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+#ifndef UDC_THREAD_POOL_H
+#define UDC_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief A small fixed-size pool of worker threads used by the UDC algorithms.
+ *
+ * The pool runs one parallel loop at a time.  The calling thread takes
+ * part in the loop as worker 0, so a pool of size 1 spawns no threads
+ * and runs everything inline.  A loop started from inside a task runs
+ * serially on the calling worker instead of deadlocking the pool.  Loops
+ * started from several threads at once are safe, and run one after the
+ * other.
+ *
+ * ParallelFor hands out tasks one at a time from a shared counter.
+ * ParallelForStealing gives every worker a contiguous range of tasks up
+ * front instead, and lets a worker that runs out steal half of what is
+ * left of another's range, which suits fewer, larger and uneven tasks.
+ */
+class UdcThreadPool
+{
+public:
+  /**
+   * \param threads the number of workers, including the calling thread;
+   *        0 selects std::thread::hardware_concurrency ()
+   */
+  explicit UdcThreadPool (unsigned threads)
+  {
+    if (threads == 0)
+      {
+        threads = std::max (1u, std::thread::hardware_concurrency ());
+      }
+    m_ranges = std::vector<std::atomic<uint64_t>> (threads);
+    for (unsigned w = 1; w < threads; ++w)
+      {
+        m_workers.emplace_back (&UdcThreadPool::WorkerLoop, this, w);
+      }
+  }
+
+  ~UdcThreadPool ()
+  {
+    {
+      std::lock_guard<std::mutex> lock (m_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_all ();
+    for (std::thread &t : m_workers)
+      {
+        t.join ();
+      }
+  }
+
+  UdcThreadPool (const UdcThreadPool &) = delete;
+  UdcThreadPool &operator= (const UdcThreadPool &) = delete;
+
+  /**
+   * \return the number of workers, including the calling thread
+   */
+  unsigned GetN (void) const
+  {
+    return m_workers.size () + 1;
+  }
+
+  /**
+   * \brief Run fn (task, worker) for every task in [0, tasks).
+   *
+   * Tasks are handed out dynamically, so uneven tasks balance themselves.
+   * The worker index is in [0, GetN ()) and is stable for the duration of
+   * a task, which lets callers keep per-worker scratch buffers.
+   */
+  template <typename F>
+  void ParallelFor (size_t tasks, F &&fn)
+  {
+    if (tasks == 0)
+      {
+        return;
+      }
+    if (m_workers.empty () || tasks == 1 || t_insidePool)
+      {
+        for (size_t t = 0; t < tasks; ++t)
+          {
+            fn (t, 0u);
+          }
+        return;
+      }
+
+    Run (tasks, false, fn);
+  }
+
+  /**
+   * \brief Run fn (task, worker) for every task in [0, tasks), with work
+   * stealing.
+   *
+   * Worker w starts on the w-th of GetN () equal ranges of the tasks and
+   * runs them in order; lower task indices should be the larger tasks.
+   */
+  template <typename F>
+  void ParallelForStealing (size_t tasks, F &&fn)
+  {
+    if (tasks == 0)
+      {
+        return;
+      }
+    if (m_workers.empty () || tasks == 1 || t_insidePool)
+      {
+        for (size_t t = 0; t < tasks; ++t)
+          {
+            fn (t, 0u);
+          }
+        return;
+      }
+    Run (tasks, true, fn);
+  }
+
+private:
+  template <typename F>
+  void Run (size_t tasks, bool stealing, F &fn)
+  {
+    std::lock_guard<std::mutex> run (m_runMutex);
+    std::unique_lock<std::mutex> lock (m_mutex);
+    m_job = [&fn] (size_t t, unsigned w) { fn (t, w); };
+    m_tasks = tasks;
+    m_next = 0;
+    m_stealing = stealing;
+    if (stealing)
+      {
+        for (size_t w = 0; w < m_ranges.size (); ++w)
+          {
+            m_ranges[w].store (Range (tasks * w / m_ranges.size (), tasks * (w + 1) / m_ranges.size ()));
+          }
+      }
+    m_active = m_workers.size ();
+    ++m_generation;
+    lock.unlock ();
+    m_wake.notify_all ();
+
+    RunTasks (0);
+
+    lock.lock ();
+    m_done.wait (lock, [this] { return m_active == 0; });
+    m_job = nullptr;
+  }
+
+  void WorkerLoop (unsigned worker)
+  {
+    uint64_t seen = 0;
+    for (;;)
+      {
+        {
+          std::unique_lock<std::mutex> lock (m_mutex);
+          m_wake.wait (lock, [this, seen] { return m_stop || m_generation != seen; });
+          if (m_stop)
+            {
+              return;
+            }
+          seen = m_generation;
+        }
+        RunTasks (worker);
+        {
+          std::lock_guard<std::mutex> lock (m_mutex);
+          if (--m_active == 0)
+            {
+              m_done.notify_one ();
+            }
+        }
+      }
+  }
+
+  void RunTasks (unsigned worker)
+  {
+    t_insidePool = true;
+    if (m_stealing)
+      {
+        StealTasks (worker);
+      }
+    else
+      {
+        for (size_t t = m_next++; t < m_tasks; t = m_next++)
+          {
+            m_job (t, worker);
+          }
+      }
+    t_insidePool = false;
+  }
+
+  /**
+   * Pack a range of tasks, begin in the high half
+   */
+  static uint64_t Range (uint64_t begin, uint64_t end)
+  {
+    return begin << 32 | end;
+  }
+
+  /**
+   * Run the worker's own range from the front, then steal the back half
+   * of the largest range left, until every range is empty.
+   */
+  void StealTasks (unsigned worker)
+  {
+    std::atomic<uint64_t> &own = m_ranges[worker];
+    for (;;)
+      {
+        uint64_t range = own.load ();
+        while (uint32_t (range >> 32) < uint32_t (range))
+          {
+            if (own.compare_exchange_weak (range, range + (uint64_t (1) << 32)))
+              {
+                m_job (range >> 32, worker);
+                range = own.load ();
+              }
+          }
+
+        bool stolen = false;
+        while (!stolen)
+          {
+            size_t victim = 0;
+            uint64_t victimRange = 0;
+            uint32_t most = 0;
+            for (size_t w = 0; w < m_ranges.size (); ++w)
+              {
+                const uint64_t r = m_ranges[w].load ();
+                const uint32_t left = uint32_t (r) - std::min (uint32_t (r), uint32_t (r >> 32));
+                if (left > most)
+                  {
+                    most = left;
+                    victim = w;
+                    victimRange = r;
+                  }
+              }
+            if (most == 0)
+              {
+                return;
+              }
+            const uint64_t begin = victimRange >> 32, end = uint32_t (victimRange);
+            const uint64_t split = end - std::max<uint64_t> (1, (end - begin) / 2);
+            if (m_ranges[victim].compare_exchange_strong (victimRange, Range (begin, split)))
+              {
+                own.store (Range (split, end));
+                stolen = true;
+              }
+          }
+      }
+  }
+
+  std::vector<std::thread> m_workers;
+  std::mutex m_runMutex; //!< held by the thread running a loop, for the whole loop
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  std::function<void (size_t, unsigned)> m_job;
+  size_t m_tasks = 0;
+  std::atomic<size_t> m_next {0};
+  bool m_stealing = false;
+  std::vector<std::atomic<uint64_t>> m_ranges; //!< ParallelForStealing: tasks left to each worker
+  unsigned m_active = 0;
+  uint64_t m_generation = 0;
+  bool m_stop = false;
+
+  static inline thread_local bool t_insidePool = false; //!< set while a worker runs tasks
+};
+
+} // namespace ns3
+
+#endif /* UDC_THREAD_POOL_H */
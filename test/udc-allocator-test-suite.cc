@@ -0,0 +1,1303 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+
+#include "ns3/boolean.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/enum.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/string.h"
+#include "ns3/test.h"
+#include "ns3/udc-allocator.h"
+#include "ns3/udc-site-store.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace ns3;
+
+/**
+ * Sites of a test, and the radius to cover them with
+ */
+struct UdcTestSites
+{
+  std::vector<double> x, y;
+  double radius;
+};
+
+/**
+ * \return n sites uniform over a square of the given side
+ */
+static UdcTestSites
+UniformSites (size_t n, double side, double radius, unsigned seed)
+{
+  std::mt19937_64 generator (seed);
+  std::uniform_real_distribution<double> coordinate (0, side);
+  UdcTestSites sites;
+  sites.radius = radius;
+  for (size_t i = 0; i < n; ++i)
+    {
+      sites.x.push_back (coordinate (generator));
+      sites.y.push_back (coordinate (generator));
+    }
+  return sites;
+}
+
+/**
+ * \return n sites in a normal cluster of the given deviation
+ */
+static UdcTestSites
+ClusteredSites (size_t n, double deviation, double radius, unsigned seed)
+{
+  std::mt19937_64 generator (seed);
+  std::normal_distribution<double> coordinate (0, deviation);
+  UdcTestSites sites;
+  sites.radius = radius;
+  for (size_t i = 0; i < n; ++i)
+    {
+      sites.x.push_back (coordinate (generator));
+      sites.y.push_back (coordinate (generator));
+    }
+  return sites;
+}
+
+/**
+ * \return sites on a grid a quarter of a FAST_COVER cell apart, so that
+ * every cell edge and every band seam has sites on it, in shuffled order
+ */
+static UdcTestSites
+LatticeSites (size_t side, double radius, unsigned seed)
+{
+  const double step = std::sqrt (2) * radius / 4;
+  UdcTestSites sites;
+  sites.radius = radius;
+  std::vector<std::pair<double, double>> grid;
+  for (size_t i = 0; i < side; ++i)
+    {
+      for (size_t j = 0; j < side; ++j)
+        {
+          grid.push_back ({i * step, j * step});
+        }
+    }
+  std::mt19937_64 generator (seed);
+  std::shuffle (grid.begin (), grid.end (), generator);
+  for (const auto &site : grid)
+    {
+      sites.x.push_back (site.first);
+      sites.y.push_back (site.second);
+    }
+  return sites;
+}
+
+/**
+ * \return sites just either side of the edges between FAST_COVER columns,
+ * within the reach of the disks of the neighboring column, so that most
+ * of them need a cell of another band
+ */
+static UdcTestSites
+SeamSites (size_t n, size_t columns, double radius, unsigned seed)
+{
+  const double width = std::sqrt (2) * radius;
+  std::mt19937_64 generator (seed);
+  std::uniform_int_distribution<size_t> column (1, columns);
+  std::uniform_real_distribution<double> offset (-0.25 * width, 0.25 * width), row (0, columns * width);
+  UdcTestSites sites;
+  sites.radius = radius;
+  for (size_t i = 0; i < n; ++i)
+    {
+      sites.x.push_back (column (generator) * width + offset (generator));
+      sites.y.push_back (row (generator));
+    }
+  return sites;
+}
+
+/**
+ * \return the given sites each repeated copies times, in shuffled order
+ */
+static UdcTestSites
+Duplicated (const UdcTestSites &from, size_t copies, unsigned seed)
+{
+  std::vector<size_t> order;
+  for (size_t c = 0; c < copies; ++c)
+    {
+      for (size_t i = 0; i < from.x.size (); ++i)
+        {
+          order.push_back (i);
+        }
+    }
+  std::mt19937_64 generator (seed);
+  std::shuffle (order.begin (), order.end (), generator);
+  UdcTestSites sites;
+  sites.radius = from.radius;
+  for (size_t i : order)
+    {
+      sites.x.push_back (from.x[i]);
+      sites.y.push_back (from.y[i]);
+    }
+  return sites;
+}
+
+/**
+ * \return an allocator running the given algorithm on the given number
+ * of threads, its other attributes at their defaults
+ */
+static Ptr<UDCPositionAllocator>
+CreateAllocator (UDCPositionAllocator::Algorithm algorithm, uint32_t threads = 1)
+{
+  Ptr<UDCPositionAllocator> allocator = CreateObject<UDCPositionAllocator> ();
+  allocator->SetAttribute ("Threads", UintegerValue (threads));
+  allocator->SetAlgorithm (algorithm);
+  return allocator;
+}
+
+/**
+ * \brief Give the sites to an allocator and cover them
+ */
+static void
+Cover (Ptr<UDCPositionAllocator> allocator, const UdcTestSites &sites)
+{
+  allocator->SetSites (sites.x.data (), sites.y.data (), sites.x.size ());
+  allocator->CoverSites (sites.radius);
+}
+
+/**
+ * \return the name of an algorithm, for the names of the test cases
+ */
+static std::string
+AlgorithmName (UDCPositionAllocator::Algorithm algorithm)
+{
+  static const char *names[] = {"FAST_COVER", "SWEEP", "STRIPS", "FAST_COVER_HEX", "PORTFOLIO"};
+  return names[algorithm];
+}
+
+/**
+ * \ingroup mobility-test
+ * \brief FAST_COVER on several threads places the disks of FAST_COVER on
+ * one, in the same order, and assigns every site to the same disk.
+ */
+class UdcParallelFastCoverTestCase : public TestCase
+{
+public:
+  UdcParallelFastCoverTestCase (std::string name, UdcTestSites sites);
+
+private:
+  virtual void DoRun (void);
+
+  UdcTestSites m_sites;
+};
+
+UdcParallelFastCoverTestCase::UdcParallelFastCoverTestCase (std::string name, UdcTestSites sites)
+  : TestCase ("Parallel FAST_COVER equals serial on " + name),
+    m_sites (std::move (sites))
+{
+}
+
+void
+UdcParallelFastCoverTestCase::DoRun (void)
+{
+  Ptr<UDCPositionAllocator> serial = CreateAllocator (UDCPositionAllocator::FAST_COVER);
+  serial->SetAttribute ("RecordAssignment", BooleanValue (true));
+  Cover (serial, m_sites);
+  const std::vector<Vector> &disks = serial->GetPositions ();
+  NS_TEST_ASSERT_MSG_GT (disks.size (), 0, "No disks placed");
+
+  for (uint32_t threads : {2, 3, 8})
+    {
+      Ptr<UDCPositionAllocator> parallel = CreateAllocator (UDCPositionAllocator::FAST_COVER, threads);
+      parallel->SetAttribute ("RecordAssignment", BooleanValue (true));
+      // Bands of any size, so that these small inputs are tiled
+      parallel->SetAttribute ("MinBandSites", UintegerValue (1));
+      Cover (parallel, m_sites);
+      const std::vector<Vector> &parallelDisks = parallel->GetPositions ();
+      NS_TEST_ASSERT_MSG_EQ (parallelDisks.size (), disks.size (),
+                             "Different number of disks on " << threads << " threads");
+      for (size_t d = 0; d < disks.size (); ++d)
+        {
+          NS_TEST_ASSERT_MSG_EQ (parallelDisks[d].x, disks[d].x,
+                                 "Disk " << d << " differs on " << threads << " threads");
+          NS_TEST_ASSERT_MSG_EQ (parallelDisks[d].y, disks[d].y,
+                                 "Disk " << d << " differs on " << threads << " threads");
+        }
+      for (size_t i = 0; i < m_sites.x.size (); ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ (parallel->GetAssignment ().GetGateway (i), serial->GetAssignment ().GetGateway (i),
+                                 "Site " << i << " assigned differently on " << threads << " threads");
+        }
+    }
+}
+
+/**
+ * \ingroup mobility-test
+ * \brief Every algorithm covers every site, alone and with the attributes
+ * that change how the cover is made or how the sites are stored.
+ */
+class UdcVerifyCoverTestCase : public TestCase
+{
+public:
+  UdcVerifyCoverTestCase (std::string name, UdcTestSites sites, UDCPositionAllocator::Algorithm algorithm);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Check the cover of an allocator already given its attributes
+   */
+  void CheckCover (Ptr<UDCPositionAllocator> allocator, std::string settings);
+
+  UdcTestSites m_sites;
+  UDCPositionAllocator::Algorithm m_algorithm;
+};
+
+UdcVerifyCoverTestCase::UdcVerifyCoverTestCase (std::string name, UdcTestSites sites,
+                                                UDCPositionAllocator::Algorithm algorithm)
+  : TestCase (AlgorithmName (algorithm) + " covers " + name),
+    m_sites (std::move (sites)),
+    m_algorithm (algorithm)
+{
+}
+
+void
+UdcVerifyCoverTestCase::CheckCover (Ptr<UDCPositionAllocator> allocator, std::string settings)
+{
+  Cover (allocator, m_sites);
+  NS_TEST_ASSERT_MSG_GT (allocator->GetSize (), 0, "No disks placed " << settings);
+  const UDCPositionAllocator::CoverReport report = allocator->VerifyCover ();
+  NS_TEST_EXPECT_MSG_EQ (report.sites, m_sites.x.size (), "Not every site checked " << settings);
+  NS_TEST_EXPECT_MSG_EQ (report.uncovered, 0, "Sites left uncovered " << settings);
+  // The centers computed from the sites may round past the radius, by the
+  // slack VerifyCover allows
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (report.maxDistance, m_sites.radius * (1 + 1e-9), "A site is out of reach " << settings);
+}
+
+void
+UdcVerifyCoverTestCase::DoRun (void)
+{
+  CheckCover (CreateAllocator (m_algorithm), "alone");
+  CheckCover (CreateAllocator (m_algorithm, 4), "on 4 threads");
+
+  Ptr<UDCPositionAllocator> allocator = CreateAllocator (m_algorithm);
+  allocator->SetAttribute ("Components", BooleanValue (true));
+  CheckCover (allocator, "by components");
+
+  allocator = CreateAllocator (m_algorithm);
+  allocator->SetAttribute ("PruneRedundant", BooleanValue (true));
+  CheckCover (allocator, "pruned");
+
+  allocator = CreateAllocator (m_algorithm);
+  allocator->SetAttribute ("Geometry", EnumValue (UDCPositionAllocator::GEOMETRY_FLOAT));
+  CheckCover (allocator, "in float geometry");
+
+  allocator = CreateAllocator (m_algorithm);
+  allocator->SetAttribute ("SweepEngine", EnumValue (UDCPositionAllocator::SWEEP_BUCKETS));
+  CheckCover (allocator, "with the bucketed sweep");
+
+  allocator = CreateAllocator (m_algorithm);
+  allocator->SetAttribute ("SitePrecision", EnumValue (UdcSiteStore::QUANTIZED));
+  CheckCover (allocator, "with quantized sites");
+}
+
+/**
+ * \ingroup mobility-test
+ * \brief CoverSiteFile places the disks of CoverSites for SWEEP and
+ * STRIPS, in the same order, even when the sites do not fit in its
+ * memory budget.
+ */
+class UdcCoverSiteFileTestCase : public TestCase
+{
+public:
+  UdcCoverSiteFileTestCase (std::string name, UdcTestSites sites, UDCPositionAllocator::Algorithm algorithm);
+
+private:
+  virtual void DoRun (void);
+
+  UdcTestSites m_sites;
+  UDCPositionAllocator::Algorithm m_algorithm;
+};
+
+UdcCoverSiteFileTestCase::UdcCoverSiteFileTestCase (std::string name, UdcTestSites sites,
+                                                    UDCPositionAllocator::Algorithm algorithm)
+  : TestCase ("CoverSiteFile equals CoverSites for " + AlgorithmName (algorithm) + " on " + name),
+    m_sites (std::move (sites)),
+    m_algorithm (algorithm)
+{
+}
+
+void
+UdcCoverSiteFileTestCase::DoRun (void)
+{
+  const std::string siteFile = CreateTempDirFilename ("sites.udc"), diskFile = CreateTempDirFilename ("disks.udc");
+  NS_TEST_ASSERT_MSG_EQ (UdcSiteStore::WriteFile (siteFile, m_sites.x.data (), m_sites.y.data (), m_sites.x.size ()),
+                         true, "Cannot write " << siteFile);
+
+  Ptr<UDCPositionAllocator> allocator = CreateAllocator (m_algorithm);
+  // The smallest budget, so that the sites are sorted in several runs
+  allocator->SetAttribute ("MemoryBudget", UintegerValue (uint64_t (1) << 20));
+  Cover (allocator, m_sites);
+  NS_TEST_ASSERT_MSG_EQ (allocator->CoverSiteFile (siteFile, m_sites.radius, diskFile), true,
+                         "Cannot cover " << siteFile);
+
+  UdcSiteStore disks;
+  NS_TEST_ASSERT_MSG_EQ (disks.MapFile (diskFile), true, "Cannot read " << diskFile);
+  const std::vector<Vector> &positions = allocator->GetPositions ();
+  NS_TEST_ASSERT_MSG_EQ (disks.GetN (), positions.size (), "Different number of disks");
+  for (size_t d = 0; d < positions.size (); ++d)
+    {
+      NS_TEST_ASSERT_MSG_EQ (disks.X (d), positions[d].x, "Disk " << d << " differs");
+      NS_TEST_ASSERT_MSG_EQ (disks.Y (d), positions[d].y, "Disk " << d << " differs");
+    }
+  std::remove (siteFile.c_str ());
+  std::remove (diskFile.c_str ());
+}
+
+/**
+ * \ingroup mobility-test
+ * \brief A cover written to the cache is read back, in the same order,
+ * by another allocator with the same sites and settings, and not by one
+ * with another radius.
+ */
+class UdcCoverCacheTestCase : public TestCase
+{
+public:
+  UdcCoverCacheTestCase (UDCPositionAllocator::Algorithm algorithm);
+
+private:
+  virtual void DoRun (void);
+
+  UDCPositionAllocator::Algorithm m_algorithm;
+};
+
+UdcCoverCacheTestCase::UdcCoverCacheTestCase (UDCPositionAllocator::Algorithm algorithm)
+  : TestCase ("The cache round-trips a " + AlgorithmName (algorithm) + " cover"),
+    m_algorithm (algorithm)
+{
+}
+
+void
+UdcCoverCacheTestCase::DoRun (void)
+{
+  const std::string directory = CreateTempDirFilename ("cache-" + AlgorithmName (m_algorithm));
+  const UdcTestSites sites = ClusteredSites (10000, 1000, 30, 11);
+
+  Ptr<UDCPositionAllocator> computed = CreateAllocator (m_algorithm);
+  computed->SetAttribute ("CacheDirectory", StringValue (directory));
+  Cover (computed, sites);
+
+  Ptr<UDCPositionAllocator> read = CreateAllocator (m_algorithm);
+  read->SetAttribute ("CacheDirectory", StringValue (directory));
+  Cover (read, sites);
+  const std::vector<Vector> &disks = computed->GetPositions (), &readDisks = read->GetPositions ();
+  NS_TEST_ASSERT_MSG_EQ (readDisks.size (), disks.size (), "Different number of disks read back");
+  for (size_t d = 0; d < disks.size (); ++d)
+    {
+      NS_TEST_ASSERT_MSG_EQ (readDisks[d].x, disks[d].x, "Disk " << d << " read back differs");
+      NS_TEST_ASSERT_MSG_EQ (readDisks[d].y, disks[d].y, "Disk " << d << " read back differs");
+    }
+
+  UdcTestSites farther = sites;
+  farther.radius *= 2;
+  Ptr<UDCPositionAllocator> other = CreateAllocator (m_algorithm);
+  other->SetAttribute ("CacheDirectory", StringValue (directory));
+  Cover (other, farther);
+  NS_TEST_EXPECT_MSG_LT (other->GetSize (), disks.size (), "A cover of another radius was read back");
+#if UDC_STATS
+  // Only a cover computed counts the disks it places
+  NS_TEST_EXPECT_MSG_EQ (computed->GetStats ().disks, disks.size (), "The first cover was not computed");
+  NS_TEST_EXPECT_MSG_EQ (read->GetStats ().disks, 0, "The second cover was not read from the cache");
+  NS_TEST_EXPECT_MSG_EQ (other->GetStats ().disks, other->GetSize (), "The cover of another radius was not computed");
+#endif
+}
+
+/**
+ * \ingroup mobility-test
+ * \brief The nearest, k nearest and within range queries of the gateways
+ * agree with a scan of every gateway.
+ */
+class UdcGatewayQueryTestCase : public TestCase
+{
+public:
+  UdcGatewayQueryTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+UdcGatewayQueryTestCase::UdcGatewayQueryTestCase ()
+  : TestCase ("Gateway queries equal a scan of every gateway")
+{
+}
+
+void
+UdcGatewayQueryTestCase::DoRun (void)
+{
+  const UdcTestSites sites = ClusteredSites (20000, 1000, 40, 21);
+  Ptr<UDCPositionAllocator> allocator = CreateAllocator (UDCPositionAllocator::STRIPS, 4);
+  Cover (allocator, sites);
+  const std::vector<Vector> &disks = allocator->GetPositions ();
+
+  // Points among the gateways, far out of their bounds, and on gateways
+  UdcTestSites points = UniformSites (2000, 8000, 0, 22);
+  for (double &x : points.x)
+    {
+      x -= 4000;
+    }
+  for (double &y : points.y)
+    {
+      y -= 4000;
+    }
+  points.x.push_back (1e6);
+  points.y.push_back (-1e6);
+  for (size_t d = 0; d < disks.size (); d += 97)
+    {
+      points.x.push_back (disks[d].x);
+      points.y.push_back (disks[d].y);
+    }
+  const size_t n = points.x.size (), k = 5;
+
+  std::vector<uint32_t> nearest (n * k);
+  allocator->FindNearestGateways (points.x.data (), points.y.data (), n, k, nearest.data ());
+  const double range = 2.5 * sites.radius;
+  std::vector<uint64_t> first;
+  std::vector<uint32_t> within;
+  allocator->FindGatewaysWithin (points.x.data (), points.y.data (), n, range, first, within);
+  NS_TEST_ASSERT_MSG_EQ (first.size (), n + 1, "FindGatewaysWithin gives no range for every point");
+
+  for (size_t i = 0; i < n; ++i)
+    {
+      // Every gateway by distance, ties by index, as the index breaks them
+      std::vector<std::pair<double, uint32_t>> scan;
+      std::vector<uint32_t> scanWithin;
+      for (uint32_t d = 0; d < disks.size (); ++d)
+        {
+          const double dx = points.x[i] - disks[d].x, dy = points.y[i] - disks[d].y;
+          scan.push_back ({dx * dx + dy * dy, d});
+          if (dx * dx + dy * dy <= range * range)
+            {
+              scanWithin.push_back (d);
+            }
+        }
+      std::sort (scan.begin (), scan.end ());
+
+      NS_TEST_ASSERT_MSG_EQ (allocator->GetGatewayIndex ().Nearest (points.x[i], points.y[i]), scan[0].second,
+                             "Nearest gateway of point " << i);
+      for (size_t j = 0; j < k; ++j)
+        {
+          NS_TEST_ASSERT_MSG_EQ (nearest[i * k + j], scan[j].second, "Gateway " << j << " nearest to point " << i);
+        }
+      std::vector<uint32_t> found (within.begin () + first[i], within.begin () + first[i + 1]);
+      std::sort (found.begin (), found.end ());
+      NS_TEST_ASSERT_MSG_EQ (found == scanWithin, true, "Gateways within range of point " << i);
+    }
+}
+
+/**
+ * \ingroup mobility-test
+ * \brief AddSite and RemoveSite keep every site covered, report the disks
+ * they add and remove, and find the sites given through SetSites at every
+ * SitePrecision.
+ */
+class UdcIncrementalTestCase : public TestCase
+{
+public:
+  UdcIncrementalTestCase (UdcSiteStore::Precision precision);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Check that the cover holds every one of the given number of sites
+   */
+  void CheckCover (Ptr<UDCPositionAllocator> allocator, size_t sites, std::string step);
+
+  UdcSiteStore::Precision m_precision;
+};
+
+UdcIncrementalTestCase::UdcIncrementalTestCase (UdcSiteStore::Precision precision)
+  : TestCase (std::string ("AddSite and RemoveSite on ") + (precision == UdcSiteStore::DOUBLE  ? "double"
+                                                             : precision == UdcSiteStore::FLOAT ? "float"
+                                                                                                : "quantized")
+              + " sites"),
+    m_precision (precision)
+{
+}
+
+void
+UdcIncrementalTestCase::CheckCover (Ptr<UDCPositionAllocator> allocator, size_t sites, std::string step)
+{
+  const UDCPositionAllocator::CoverReport report = allocator->VerifyCover ();
+  NS_TEST_EXPECT_MSG_EQ (report.sites, sites, "Wrong number of sites " << step);
+  NS_TEST_EXPECT_MSG_EQ (report.uncovered, 0, "Sites left uncovered " << step);
+}
+
+void
+UdcIncrementalTestCase::DoRun (void)
+{
+  // Away from the origin, so that no stored coordinate reads back exactly,
+  // with one site alone in its disk
+  UdcTestSites sites = ClusteredSites (2000, 300, 20, 31);
+  for (size_t i = 0; i < sites.x.size (); ++i)
+    {
+      sites.x[i] += 5000;
+      sites.y[i] += 5000;
+    }
+  const Vector alone (9000.1234567, 9000.7654321, 0);
+  sites.x.push_back (alone.x);
+  sites.y.push_back (alone.y);
+  const size_t n = sites.x.size ();
+
+  Ptr<UDCPositionAllocator> allocator = CreateAllocator (UDCPositionAllocator::FAST_COVER);
+  allocator->SetAttribute ("SitePrecision", EnumValue (m_precision));
+  Cover (allocator, sites);
+  const size_t disks = allocator->GetSize ();
+  CheckCover (allocator, n, "after CoverSites");
+
+  const Vector far (20000, 20000, 0);
+  UDCPositionAllocator::CoverDelta delta = allocator->AddSite (far);
+  NS_TEST_ASSERT_MSG_EQ (delta.added.size (), 1, "No disk added for a site out of reach");
+  NS_TEST_EXPECT_MSG_EQ (delta.removed.size (), 0, "A disk removed by AddSite");
+  NS_TEST_EXPECT_MSG_EQ (allocator->GetSize (), disks + 1, "The added disk is not in the cover");
+  CheckCover (allocator, n + 1, "after adding a site out of reach");
+  const Vector added = delta.added[0];
+
+  delta = allocator->AddSite (Vector (sites.x[1], sites.y[1], 0));
+  NS_TEST_EXPECT_MSG_EQ (delta.added.size (), 0, "A disk added for a covered site");
+  CheckCover (allocator, n + 2, "after adding a covered site");
+
+  delta = allocator->RemoveSite (far);
+  NS_TEST_ASSERT_MSG_EQ (delta.removed.size (), 1, "The disk of a removed site is kept");
+  NS_TEST_EXPECT_MSG_EQ (delta.removed[0].x, added.x, "Another disk removed");
+  NS_TEST_EXPECT_MSG_EQ (delta.removed[0].y, added.y, "Another disk removed");
+  NS_TEST_EXPECT_MSG_EQ (delta.added.size (), 0, "A disk added by RemoveSite");
+  CheckCover (allocator, n + 1, "after removing the added site");
+
+  // Sites given to SetSites are found at the precision they are stored at
+  delta = allocator->RemoveSite (alone);
+  NS_TEST_EXPECT_MSG_EQ (delta.removed.size (), 1, "The disk of a removed site is kept");
+  NS_TEST_EXPECT_MSG_EQ (allocator->GetSize (), disks - 1, "The cover does not shrink");
+  CheckCover (allocator, n, "after removing a site alone in its disk");
+
+  delta = allocator->RemoveSite (Vector (sites.x[0], sites.y[0], 0), false);
+  NS_TEST_EXPECT_MSG_EQ (delta.removed.size (), 0, "A disk removed without dropEmpty");
+  CheckCover (allocator, n - 1, "after removing a clustered site");
+
+  delta = allocator->RemoveSite (Vector (sites.x[2] + 1, sites.y[2], 0));
+  NS_TEST_EXPECT_MSG_EQ (delta.removed.size (), 0, "A disk removed for a site never given");
+  CheckCover (allocator, n - 1, "after removing a site never given");
+}
+
+/**
+ * \ingroup mobility-test
+ * \brief The sites of raw buffers, of a site file and of nodes give the
+ * same cover, and a site file that cannot be read leaves the sites as
+ * they were.
+ */
+class UdcSiteInputTestCase : public TestCase
+{
+public:
+  UdcSiteInputTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Check that the cover of an allocator is the given one
+   */
+  void CheckSame (Ptr<UDCPositionAllocator> allocator, const std::vector<Vector> &disks, std::string input);
+};
+
+UdcSiteInputTestCase::UdcSiteInputTestCase ()
+  : TestCase ("Buffers, site files and nodes give the same sites")
+{
+}
+
+void
+UdcSiteInputTestCase::CheckSame (Ptr<UDCPositionAllocator> allocator, const std::vector<Vector> &disks,
+                                 std::string input)
+{
+  const std::vector<Vector> &positions = allocator->GetPositions ();
+  NS_TEST_ASSERT_MSG_EQ (positions.size (), disks.size (), "Different number of disks from " << input);
+  for (size_t d = 0; d < disks.size (); ++d)
+    {
+      NS_TEST_ASSERT_MSG_EQ (positions[d].x, disks[d].x, "Disk " << d << " differs from " << input);
+      NS_TEST_ASSERT_MSG_EQ (positions[d].y, disks[d].y, "Disk " << d << " differs from " << input);
+    }
+}
+
+void
+UdcSiteInputTestCase::DoRun (void)
+{
+  const UdcTestSites sites = ClusteredSites (5000, 500, 20, 41);
+  const size_t n = sites.x.size ();
+  Ptr<UDCPositionAllocator> buffers = CreateAllocator (UDCPositionAllocator::SWEEP);
+  Cover (buffers, sites);
+  const std::vector<Vector> &disks = buffers->GetPositions ();
+  NS_TEST_ASSERT_MSG_GT (disks.size (), 0, "No disks placed");
+
+  const std::string siteFile = CreateTempDirFilename ("input.udc");
+  NS_TEST_ASSERT_MSG_EQ (UdcSiteStore::WriteFile (siteFile, sites.x.data (), sites.y.data (), n), true,
+                         "Cannot write " << siteFile);
+  Ptr<UDCPositionAllocator> file = CreateAllocator (UDCPositionAllocator::SWEEP);
+  NS_TEST_ASSERT_MSG_EQ (file->SetSitesFromFile (siteFile), true, "Cannot read " << siteFile);
+  file->CoverSites (sites.radius);
+  CheckSame (file, disks, "a site file");
+
+  NodeContainer nodes;
+  nodes.Create (n);
+  for (size_t i = 0; i < n; ++i)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (sites.x[i], sites.y[i], 0));
+      nodes.Get (i)->AggregateObject (mobility);
+    }
+  Ptr<UDCPositionAllocator> node = CreateAllocator (UDCPositionAllocator::SWEEP);
+  node->SetSites (nodes);
+  node->CoverSites (sites.radius);
+  CheckSame (node, disks, "nodes");
+
+  // A missing file, and files too short for their header or their sites
+  const std::string shortFile = CreateTempDirFilename ("short.udc"), cutFile = CreateTempDirFilename ("cut.udc");
+  std::FILE *out = std::fopen (shortFile.c_str (), "wb");
+  NS_TEST_ASSERT_MSG_NE (out, nullptr, "Cannot write " << shortFile);
+  std::fputs ("UDC", out);
+  std::fclose (out);
+  NS_TEST_ASSERT_MSG_EQ (UdcSiteStore::WriteFile (cutFile, sites.x.data (), sites.y.data (), n), true,
+                         "Cannot write " << cutFile);
+  NS_TEST_ASSERT_MSG_EQ (truncate (cutFile.c_str (), 1000), 0, "Cannot cut " << cutFile);
+  for (const std::string &bad : {CreateTempDirFilename ("missing.udc"), shortFile, cutFile})
+    {
+      NS_TEST_EXPECT_MSG_EQ (node->SetSitesFromFile (bad), false, "Read the sites of " << bad);
+    }
+  node->CoverSites (sites.radius);
+  CheckSame (node, disks, "nodes after reading bad site files");
+  NS_TEST_EXPECT_MSG_EQ (node->VerifyCover ().sites, n, "Sites lost to bad site files");
+  std::remove (siteFile.c_str ());
+  std::remove (shortFile.c_str ());
+  std::remove (cutFile.c_str ());
+}
+
+/**
+ * \ingroup mobility-test
+ * \brief PruneRedundant removes the disks whose sites other disks cover,
+ * reports how many, and keeps every disk that alone covers a site.
+ */
+class UdcPruneTestCase : public TestCase
+{
+public:
+  UdcPruneTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+UdcPruneTestCase::UdcPruneTestCase ()
+  : TestCase ("PruneRedundant removes the redundant disks")
+{
+}
+
+void
+UdcPruneTestCase::DoRun (void)
+{
+  // FAST_COVER gives the first site the disk of its cell, and the second,
+  // out of reach of that disk, the disk of the next cell, which also
+  // covers the first
+  const double radius = 10, width = std::sqrt (2) * radius;
+  UdcTestSites pair;
+  pair.x = {12, 24};
+  pair.y = {width / 2, width / 2};
+  pair.radius = radius;
+  Ptr<UDCPositionAllocator> allocator = CreateAllocator (UDCPositionAllocator::FAST_COVER);
+  Cover (allocator, pair);
+  NS_TEST_ASSERT_MSG_EQ (allocator->GetSize (), 2, "FAST_COVER did not place a disk for each site");
+  NS_TEST_EXPECT_MSG_EQ (allocator->PruneRedundant (), 1, "The redundant disk is not reported");
+  NS_TEST_ASSERT_MSG_EQ (allocator->GetSize (), 1, "The redundant disk is kept");
+  NS_TEST_EXPECT_MSG_EQ_TOL (allocator->GetPositions ()[0].x, 1.5 * width, 1e-9, "The wrong disk is kept");
+  NS_TEST_EXPECT_MSG_EQ (allocator->PruneRedundant (), 0, "A disk removed from a pruned cover");
+
+  const UdcTestSites sites = ClusteredSites (5000, 400, 20, 51);
+  allocator = CreateAllocator (UDCPositionAllocator::FAST_COVER);
+  Cover (allocator, sites);
+  const std::vector<Vector> before = allocator->GetPositions ();
+  const uint32_t removed = allocator->PruneRedundant ();
+  const std::vector<Vector> &after = allocator->GetPositions ();
+  NS_TEST_EXPECT_MSG_GT (removed, 0, "No disk of a FAST_COVER cover found redundant");
+  NS_TEST_ASSERT_MSG_EQ (after.size () + removed, before.size (), "The count removed is not reported");
+  NS_TEST_EXPECT_MSG_EQ (allocator->VerifyCover ().uncovered, 0, "Pruning uncovered sites");
+
+  // The disks left keep their order, and each is the only one over a site
+  size_t next = 0;
+  for (const Vector &disk : after)
+    {
+      while (next < before.size () && !(before[next].x == disk.x && before[next].y == disk.y))
+        {
+          ++next;
+        }
+      NS_TEST_ASSERT_MSG_LT (next++, before.size (), "The disks left are out of order");
+    }
+  const double reachSquared = sites.radius * sites.radius * (1 + 1e-9);
+  std::vector<size_t> only (after.size (), 0);
+  for (size_t i = 0; i < sites.x.size (); ++i)
+    {
+      size_t covering = 0, last = 0;
+      for (size_t d = 0; d < after.size (); ++d)
+        {
+          const double dx = sites.x[i] - after[d].x, dy = sites.y[i] - after[d].y;
+          if (dx * dx + dy * dy <= reachSquared)
+            {
+              ++covering;
+              last = d;
+            }
+        }
+      if (covering == 1)
+        {
+          ++only[last];
+        }
+    }
+  for (size_t d = 0; d < after.size (); ++d)
+    {
+      NS_TEST_ASSERT_MSG_GT (only[d], 0, "Disk " << d << " is redundant after pruning");
+    }
+
+  // The attribute prunes every cover the same way
+  Ptr<UDCPositionAllocator> pruned = CreateAllocator (UDCPositionAllocator::FAST_COVER);
+  pruned->SetAttribute ("PruneRedundant", BooleanValue (true));
+  Cover (pruned, sites);
+  NS_TEST_ASSERT_MSG_EQ (pruned->GetSize (), after.size (), "The attribute prunes differently");
+  for (size_t d = 0; d < after.size (); ++d)
+    {
+      NS_TEST_ASSERT_MSG_EQ (pruned->GetPositions ()[d].x, after[d].x, "The attribute prunes differently");
+      NS_TEST_ASSERT_MSG_EQ (pruned->GetPositions ()[d].y, after[d].y, "The attribute prunes differently");
+    }
+}
+
+/**
+ * \return the disk centers of a cover, sorted, to compare covers whose
+ * disks come in different orders
+ */
+static std::vector<std::pair<double, double>>
+SortedDisks (Ptr<UDCPositionAllocator> allocator)
+{
+  std::vector<std::pair<double, double>> disks;
+  for (const Vector &disk : allocator->GetPositions ())
+    {
+      disks.push_back ({disk.x, disk.y});
+    }
+  std::sort (disks.begin (), disks.end ());
+  return disks;
+}
+
+/**
+ * \ingroup mobility-test
+ * \brief A cover by components is the union of the covers of each
+ * component on its own, and for every algorithm but STRIPS, which picks
+ * the best shift of each job of components, the cover of the whole.
+ */
+class UdcComponentsTestCase : public TestCase
+{
+public:
+  UdcComponentsTestCase (UDCPositionAllocator::Algorithm algorithm);
+
+private:
+  virtual void DoRun (void);
+
+  UDCPositionAllocator::Algorithm m_algorithm;
+};
+
+UdcComponentsTestCase::UdcComponentsTestCase (UDCPositionAllocator::Algorithm algorithm)
+  : TestCase (AlgorithmName (algorithm) + " by components equals the cover of each component"),
+    m_algorithm (algorithm)
+{
+}
+
+void
+UdcComponentsTestCase::DoRun (void)
+{
+  // Towns far apart, each large enough to be covered as a job of its own
+  UdcTestSites sites;
+  sites.radius = 20;
+  for (int t = 0; t < 4; ++t)
+    {
+      const UdcTestSites people = UniformSites (4200, 400, sites.radius, 62 + t);
+      for (size_t i = 0; i < people.x.size (); ++i)
+        {
+          sites.x.push_back (5000 * t + people.x[i]);
+          sites.y.push_back (3000 * (t % 2) + people.y[i]);
+        }
+    }
+  // Lone sites, which join the jobs of the towns.  Only STRIPS, whose
+  // strips start at the first site of a job, covers a town differently
+  // with them.
+  if (m_algorithm != UDCPositionAllocator::STRIPS)
+    {
+      for (int i = 0; i < 30; ++i)
+        {
+          sites.x.insert (sites.x.begin () + 500 * i, 700 * i);
+          sites.y.insert (sites.y.begin () + 500 * i, -2000);
+        }
+    }
+  const size_t n = sites.x.size ();
+
+  // The components by brute force: sites at most two radii apart are linked
+  std::vector<size_t> parent (n);
+  for (size_t i = 0; i < n; ++i)
+    {
+      parent[i] = i;
+    }
+  auto find = [&parent] (size_t i) {
+    while (parent[i] != i)
+      {
+        i = parent[i] = parent[parent[i]];
+      }
+    return i;
+  };
+  const double reachSquared = 4 * sites.radius * sites.radius;
+  for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = i + 1; j < n; ++j)
+        {
+          const double dx = sites.x[i] - sites.x[j], dy = sites.y[i] - sites.y[j];
+          if (dx * dx + dy * dy <= reachSquared)
+            {
+              parent[find (i)] = find (j);
+            }
+        }
+    }
+  std::vector<std::pair<size_t, size_t>> byComponent;
+  for (size_t i = 0; i < n; ++i)
+    {
+      byComponent.push_back ({find (i), i});
+    }
+  std::sort (byComponent.begin (), byComponent.end ());
+
+  // Each component covered on its own, its sites in input order
+  std::vector<std::pair<double, double>> separate;
+  size_t components = 0;
+  for (size_t first = 0; first < n;)
+    {
+      UdcTestSites component;
+      component.radius = sites.radius;
+      size_t last = first;
+      for (; last < n && byComponent[last].first == byComponent[first].first; ++last)
+        {
+          component.x.push_back (sites.x[byComponent[last].second]);
+          component.y.push_back (sites.y[byComponent[last].second]);
+        }
+      Ptr<UDCPositionAllocator> allocator = CreateAllocator (m_algorithm);
+      Cover (allocator, component);
+      const std::vector<std::pair<double, double>> disks = SortedDisks (allocator);
+      separate.insert (separate.end (), disks.begin (), disks.end ());
+      ++components;
+      first = last;
+    }
+  std::sort (separate.begin (), separate.end ());
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (components, 4, "The towns are not components");
+
+  Ptr<UDCPositionAllocator> split = CreateAllocator (m_algorithm, 4);
+  split->SetAttribute ("Components", BooleanValue (true));
+  Cover (split, sites);
+  NS_TEST_EXPECT_MSG_EQ (split->VerifyCover ().uncovered, 0, "Sites left uncovered by components");
+  NS_TEST_EXPECT_MSG_EQ (SortedDisks (split) == separate, true, "Not the covers of the components on their own");
+
+  if (m_algorithm != UDCPositionAllocator::STRIPS)
+    {
+      Ptr<UDCPositionAllocator> whole = CreateAllocator (m_algorithm);
+      Cover (whole, sites);
+      NS_TEST_EXPECT_MSG_EQ (SortedDisks (split) == SortedDisks (whole), true, "Not the cover of the whole");
+    }
+}
+
+/**
+ * \ingroup mobility-test
+ * \brief CoverRadii covers each radius as CoverSites covers it on an
+ * allocator of its own, with and without the Components attribute, and
+ * leaves the cover of the allocator unchanged.
+ */
+class UdcCoverRadiiTestCase : public TestCase
+{
+public:
+  UdcCoverRadiiTestCase (UDCPositionAllocator::Algorithm algorithm);
+
+private:
+  virtual void DoRun (void);
+
+  UDCPositionAllocator::Algorithm m_algorithm;
+};
+
+UdcCoverRadiiTestCase::UdcCoverRadiiTestCase (UDCPositionAllocator::Algorithm algorithm)
+  : TestCase (AlgorithmName (algorithm) + " CoverRadii equals CoverSites at each radius"),
+    m_algorithm (algorithm)
+{
+}
+
+void
+UdcCoverRadiiTestCase::DoRun (void)
+{
+  // Towns far apart even at the largest radius, each large enough to be
+  // covered as a job of its own
+  std::vector<UdcTestSites> towns;
+  UdcTestSites sites;
+  sites.radius = 15;
+  for (int t = 0; t < 3; ++t)
+    {
+      UdcTestSites town = UniformSites (4200, 400, sites.radius, 71 + t);
+      for (size_t i = 0; i < town.x.size (); ++i)
+        {
+          town.x[i] += 5000 * t;
+          town.y[i] += 3000 * (t % 2);
+          sites.x.push_back (town.x[i]);
+          sites.y.push_back (town.y[i]);
+        }
+      towns.push_back (town);
+    }
+  const std::vector<double> radii = {15, 10, 25};
+
+  for (bool components : {false, true})
+    {
+      const std::string settings = components ? " by components" : "";
+      Ptr<UDCPositionAllocator> allocator = CreateAllocator (m_algorithm, 4);
+      allocator->SetAttribute ("Components", BooleanValue (components));
+      Cover (allocator, sites);
+      const std::vector<Vector> before = allocator->GetPositions ();
+      const std::vector<std::vector<Vector>> covers = allocator->CoverRadii (radii);
+      NS_TEST_ASSERT_MSG_EQ (covers.size (), radii.size (), "Not one cover per radius" << settings);
+
+      for (size_t r = 0; r < radii.size (); ++r)
+        {
+          std::vector<std::pair<double, double>> expected;
+          if (components && m_algorithm == UDCPositionAllocator::STRIPS)
+            {
+              // STRIPS picks the best shift of each town
+              for (UdcTestSites town : towns)
+                {
+                  town.radius = radii[r];
+                  Ptr<UDCPositionAllocator> alone = CreateAllocator (m_algorithm);
+                  Cover (alone, town);
+                  const std::vector<std::pair<double, double>> disks = SortedDisks (alone);
+                  expected.insert (expected.end (), disks.begin (), disks.end ());
+                }
+              std::sort (expected.begin (), expected.end ());
+            }
+          else
+            {
+              UdcTestSites atRadius = sites;
+              atRadius.radius = radii[r];
+              Ptr<UDCPositionAllocator> alone = CreateAllocator (m_algorithm);
+              Cover (alone, atRadius);
+              if (!components)
+                {
+                  // Without components, the very same disks in the same order
+                  const std::vector<Vector> &disks = alone->GetPositions ();
+                  NS_TEST_ASSERT_MSG_EQ (covers[r].size (), disks.size (),
+                                         "Radius " << radii[r] << " covered differently" << settings);
+                  for (size_t d = 0; d < disks.size (); ++d)
+                    {
+                      NS_TEST_ASSERT_MSG_EQ (covers[r][d].x, disks[d].x,
+                                             "Disk " << d << " of radius " << radii[r] << " moved");
+                      NS_TEST_ASSERT_MSG_EQ (covers[r][d].y, disks[d].y,
+                                             "Disk " << d << " of radius " << radii[r] << " moved");
+                    }
+                }
+              expected = SortedDisks (alone);
+            }
+          std::vector<std::pair<double, double>> found;
+          for (const Vector &disk : covers[r])
+            {
+              found.push_back ({disk.x, disk.y});
+            }
+          std::sort (found.begin (), found.end ());
+          NS_TEST_EXPECT_MSG_EQ (found == expected, true, "Radius " << radii[r] << " covered differently" << settings);
+        }
+
+      const std::vector<Vector> &after = allocator->GetPositions ();
+      NS_TEST_ASSERT_MSG_EQ (after.size (), before.size (), "CoverRadii changed the cover" << settings);
+      for (size_t d = 0; d < after.size (); ++d)
+        {
+          NS_TEST_ASSERT_MSG_EQ (after[d].x, before[d].x, "CoverRadii changed the cover" << settings);
+          NS_TEST_ASSERT_MSG_EQ (after[d].y, before[d].y, "CoverRadii changed the cover" << settings);
+        }
+    }
+}
+
+/**
+ * \ingroup mobility-test
+ * \brief PORTFOLIO runs FAST_COVER, FAST_COVER_HEX, SWEEP and STRIPS and
+ * keeps the finished cover with the fewest disks, and past its deadline
+ * still keeps the cover of FAST_COVER, which it never stops.
+ */
+class UdcPortfolioTestCase : public TestCase
+{
+public:
+  UdcPortfolioTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Check the runs reported, and that the cover kept is the one of
+   * the chosen run
+   * \param allocator the allocator after a PORTFOLIO cover
+   * \param settings the settings of the cover, for the messages
+   */
+  void CheckRuns (Ptr<UDCPositionAllocator> allocator, std::string settings);
+};
+
+UdcPortfolioTestCase::UdcPortfolioTestCase ()
+  : TestCase ("PORTFOLIO keeps the fewest disks of the runs finished in time")
+{
+}
+
+void
+UdcPortfolioTestCase::CheckRuns (Ptr<UDCPositionAllocator> allocator, std::string settings)
+{
+  const UDCPositionAllocator::Algorithm order[] = {
+    UDCPositionAllocator::FAST_COVER, UDCPositionAllocator::FAST_COVER_HEX, UDCPositionAllocator::SWEEP,
+    UDCPositionAllocator::STRIPS};
+  const std::vector<UDCPositionAllocator::PortfolioRun> &runs = allocator->GetPortfolioRuns ();
+  NS_TEST_ASSERT_MSG_EQ (runs.size (), 4, "Not one run per algorithm" << settings);
+  NS_TEST_EXPECT_MSG_EQ (runs[0].finished, true, "FAST_COVER did not finish" << settings);
+
+  size_t chosen = 0, best = 0;
+  for (size_t k = 0; k < runs.size (); ++k)
+    {
+      NS_TEST_EXPECT_MSG_EQ (runs[k].algorithm, order[k], "Run " << k << " out of order" << settings);
+      chosen += runs[k].chosen;
+      if (runs[k].chosen)
+        {
+          best = k;
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (chosen, 1, "Not exactly one run chosen" << settings);
+  NS_TEST_EXPECT_MSG_EQ (runs[best].finished, true, "An unfinished run chosen" << settings);
+  for (const UDCPositionAllocator::PortfolioRun &run : runs)
+    {
+      if (run.finished)
+        {
+          NS_TEST_EXPECT_MSG_GT_OR_EQ (run.disks, runs[best].disks,
+                                       AlgorithmName (run.algorithm) << " placed fewer disks" << settings);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (allocator->GetSize (), runs[best].disks, "The chosen cover is not kept" << settings);
+  NS_TEST_EXPECT_MSG_EQ (allocator->VerifyCover ().uncovered, 0, "Sites left uncovered" << settings);
+}
+
+void
+UdcPortfolioTestCase::DoRun (void)
+{
+  const UdcTestSites sites = ClusteredSites (20000, 1000, 25, 81);
+  Ptr<UDCPositionAllocator> allocator = CreateAllocator (UDCPositionAllocator::PORTFOLIO);
+  Cover (allocator, sites);
+  CheckRuns (allocator, "");
+
+  // Without a deadline every run finishes, and the cover kept is the
+  // chosen algorithm's own
+  const std::vector<UDCPositionAllocator::PortfolioRun> &runs = allocator->GetPortfolioRuns ();
+  for (const UDCPositionAllocator::PortfolioRun &run : runs)
+    {
+      NS_TEST_EXPECT_MSG_EQ (run.finished, true, AlgorithmName (run.algorithm) << " stopped without a deadline");
+      if (run.chosen)
+        {
+          Ptr<UDCPositionAllocator> alone = CreateAllocator (run.algorithm);
+          Cover (alone, sites);
+          NS_TEST_EXPECT_MSG_EQ (SortedDisks (allocator) == SortedDisks (alone), true,
+                                 "Not the cover of " << AlgorithmName (run.algorithm));
+        }
+    }
+
+  // A deadline passed at once may stop every run but FAST_COVER
+  allocator = CreateAllocator (UDCPositionAllocator::PORTFOLIO);
+  allocator->SetAttribute ("PortfolioDeadline", TimeValue (NanoSeconds (1)));
+  Cover (allocator, sites);
+  CheckRuns (allocator, " past the deadline");
+}
+
+/**
+ * \ingroup mobility-test
+ * \brief ExportLayout draws each site and disk one by one up to the
+ * LayoutPointBudget attribute, and the layers above it as tiles.
+ */
+class UdcExportLayoutTestCase : public TestCase
+{
+public:
+  UdcExportLayoutTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Count the shapes of one layer of an SVG file written by
+   * ExportLayout, which puts each shape on a line of its own
+   * \param path the SVG file
+   * \param layer the id of the group of the layer
+   * \param circles set to the points drawn one by one
+   * \param tiles set to the tiles drawn
+   * \return false if the file or the layer cannot be found
+   */
+  static bool CountShapes (const std::string &path, const std::string &layer, size_t &circles, size_t &tiles);
+};
+
+UdcExportLayoutTestCase::UdcExportLayoutTestCase ()
+  : TestCase ("ExportLayout draws tiles above the LayoutPointBudget")
+{
+}
+
+bool
+UdcExportLayoutTestCase::CountShapes (const std::string &path, const std::string &layer, size_t &circles,
+                                      size_t &tiles)
+{
+  std::ifstream in (path);
+  const std::string open = "<g id=\"" + layer + "\"";
+  std::string line;
+  bool found = false;
+  circles = tiles = 0;
+  while (std::getline (in, line))
+    {
+      if (line.compare (0, open.size (), open) == 0)
+        {
+          found = true;
+        }
+      else if (found && line == "</g>")
+        {
+          return true;
+        }
+      else if (found)
+        {
+          circles += line.compare (0, 7, "<circle") == 0;
+          tiles += line.compare (0, 5, "<rect") == 0;
+        }
+    }
+  return false;
+}
+
+void
+UdcExportLayoutTestCase::DoRun (void)
+{
+  const UdcTestSites sites = ClusteredSites (5000, 400, 20, 91);
+  const std::string path = CreateTempDirFilename ("layout.svg");
+  size_t circles, tiles;
+
+  // Every site within the budget is drawn as a circle
+  Ptr<UDCPositionAllocator> allocator = CreateAllocator (UDCPositionAllocator::FAST_COVER);
+  allocator->SetAttribute ("LayoutPointBudget", UintegerValue (sites.x.size ()));
+  Cover (allocator, sites);
+  const size_t disks = allocator->GetSize ();
+  NS_TEST_ASSERT_MSG_LT (disks, sites.x.size () / 2, "Too many disks to draw them one by one");
+  allocator->ExportLayout (path);
+  NS_TEST_ASSERT_MSG_EQ (allocator->WaitForExport (), true, "The layout within the budget was not written");
+  NS_TEST_ASSERT_MSG_EQ (CountShapes (path, "sites", circles, tiles), true, "No sites in the layout");
+  NS_TEST_EXPECT_MSG_EQ (circles, sites.x.size (), "Not every site drawn within the budget");
+  NS_TEST_EXPECT_MSG_EQ (tiles, 0, "Sites tiled within the budget");
+  NS_TEST_ASSERT_MSG_EQ (CountShapes (path, "disks", circles, tiles), true, "No disks in the layout");
+  NS_TEST_EXPECT_MSG_EQ (circles, disks, "Not every disk drawn within the budget");
+  NS_TEST_EXPECT_MSG_EQ (tiles, 0, "Disks tiled within the budget");
+
+  // One site over the budget tiles the sites, and only them
+  allocator = CreateAllocator (UDCPositionAllocator::FAST_COVER);
+  allocator->SetAttribute ("LayoutPointBudget", UintegerValue (sites.x.size () - 1));
+  Cover (allocator, sites);
+  allocator->ExportLayout (path);
+  NS_TEST_ASSERT_MSG_EQ (allocator->WaitForExport (), true, "The tiled layout was not written");
+  NS_TEST_ASSERT_MSG_EQ (CountShapes (path, "sites", circles, tiles), true, "No sites in the tiled layout");
+  NS_TEST_EXPECT_MSG_EQ (circles, 0, "Sites drawn one by one over the budget");
+  NS_TEST_EXPECT_MSG_GT (tiles, 0, "No tiles over the budget");
+  NS_TEST_EXPECT_MSG_LT (tiles, sites.x.size (), "A tile drawn per site");
+  NS_TEST_ASSERT_MSG_EQ (CountShapes (path, "disks", circles, tiles), true, "No disks in the tiled layout");
+  NS_TEST_EXPECT_MSG_EQ (circles, disks, "Disks within the budget tiled with the sites");
+
+  // A budget below the disks tiles the disks too
+  allocator->SetAttribute ("LayoutPointBudget", UintegerValue (disks / 2));
+  allocator->ExportLayout (path);
+  NS_TEST_ASSERT_MSG_EQ (allocator->WaitForExport (), true, "The tiled layout was not written");
+  NS_TEST_ASSERT_MSG_EQ (CountShapes (path, "disks", circles, tiles), true, "No disks in the tiled layout");
+  NS_TEST_EXPECT_MSG_EQ (circles, 0, "Disks drawn one by one over the budget");
+  NS_TEST_EXPECT_MSG_GT (tiles, 0, "No disk tiles over the budget");
+  std::remove (path.c_str ());
+}
+
+/**
+ * \ingroup mobility-test
+ * \brief The tests of the unit disk cover allocator.
+ */
+class UdcAllocatorTestSuite : public TestSuite
+{
+public:
+  UdcAllocatorTestSuite ();
+};
+
+UdcAllocatorTestSuite::UdcAllocatorTestSuite ()
+  : TestSuite ("udc-allocator", UNIT)
+{
+  AddTestCase (new UdcParallelFastCoverTestCase ("uniform sites", UniformSites (20000, 5000, 40, 1)), TestCase::QUICK);
+  AddTestCase (new UdcParallelFastCoverTestCase ("clustered sites", ClusteredSites (20000, 1000, 25, 2)),
+               TestCase::QUICK);
+  AddTestCase (new UdcParallelFastCoverTestCase ("sites on the cell edges", LatticeSites (120, 10, 3)),
+               TestCase::QUICK);
+  AddTestCase (new UdcParallelFastCoverTestCase ("sites along the column seams", SeamSites (20000, 64, 10, 4)),
+               TestCase::QUICK);
+  AddTestCase (new UdcParallelFastCoverTestCase ("duplicated sites",
+                                                 Duplicated (SeamSites (5000, 64, 10, 5), 4, 6)),
+               TestCase::QUICK);
+  AddTestCase (new UdcParallelFastCoverTestCase ("sparse sites", UniformSites (5000, 1e7, 5, 7)), TestCase::QUICK);
+
+  const UDCPositionAllocator::Algorithm algorithms[] = {
+    UDCPositionAllocator::FAST_COVER, UDCPositionAllocator::SWEEP, UDCPositionAllocator::STRIPS,
+    UDCPositionAllocator::FAST_COVER_HEX, UDCPositionAllocator::PORTFOLIO};
+  for (UDCPositionAllocator::Algorithm algorithm : algorithms)
+    {
+      AddTestCase (new UdcVerifyCoverTestCase ("clustered sites", ClusteredSites (5000, 1000, 25, 8), algorithm),
+                   TestCase::QUICK);
+      AddTestCase (new UdcVerifyCoverTestCase ("sites on the cell edges", LatticeSites (60, 10, 9), algorithm),
+                   TestCase::QUICK);
+      AddTestCase (new UdcVerifyCoverTestCase ("duplicated sites", Duplicated (UniformSites (1000, 400, 10, 10), 3, 10),
+                                               algorithm),
+                   TestCase::QUICK);
+      AddTestCase (new UdcCoverCacheTestCase (algorithm), TestCase::QUICK);
+      if (algorithm != UDCPositionAllocator::PORTFOLIO)
+        {
+          AddTestCase (new UdcComponentsTestCase (algorithm), TestCase::QUICK);
+          AddTestCase (new UdcCoverRadiiTestCase (algorithm), TestCase::QUICK);
+        }
+    }
+
+  for (UDCPositionAllocator::Algorithm algorithm : {UDCPositionAllocator::SWEEP, UDCPositionAllocator::STRIPS})
+    {
+      AddTestCase (new UdcCoverSiteFileTestCase ("clustered sites", ClusteredSites (100000, 5000, 20, 12), algorithm),
+                   TestCase::QUICK);
+      AddTestCase (new UdcCoverSiteFileTestCase ("duplicated sites",
+                                                 Duplicated (UniformSites (30000, 3000, 15, 13), 3, 14), algorithm),
+                   TestCase::QUICK);
+    }
+
+  AddTestCase (new UdcGatewayQueryTestCase (), TestCase::QUICK);
+  AddTestCase (new UdcSiteInputTestCase (), TestCase::QUICK);
+  AddTestCase (new UdcPruneTestCase (), TestCase::QUICK);
+  AddTestCase (new UdcPortfolioTestCase (), TestCase::QUICK);
+  AddTestCase (new UdcExportLayoutTestCase (), TestCase::QUICK);
+  for (UdcSiteStore::Precision precision : {UdcSiteStore::DOUBLE, UdcSiteStore::FLOAT, UdcSiteStore::QUANTIZED})
+    {
+      AddTestCase (new UdcIncrementalTestCase (precision), TestCase::QUICK);
+    }
+}
+
+static UdcAllocatorTestSuite g_udcAllocatorTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,518 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+
+/*
+ * udc-bench: time every variant of the algorithms on synthetic sites and
+ * report the runs as JSON, without ns-3.
+ *
+ *   udc-bench [options]
+ *
+ * Every combination of distribution, number of sites, radius, variant and
+ * number of threads is run, each the given number of times, keeping the
+ * quickest.  A run covers the sites from scratch, sorting included, as
+ * CoverSites does.
+ *
+ * Options, lists separated by commas:
+ *   --distributions=D      of uniform, normal, clustered and line; all by
+ *                          default
+ *   --sites=N              numbers of sites, 1e3,1e4,1e5,1e6 by default;
+ *                          1e8 needs several GB
+ *   --radii=R              radii, 1000,10000 by default
+ *   --variants=V           of fast, sweep, sweep-buckets, strips and hex,
+ *                          each with :double, :float or :cgal for the
+ *                          geometry; every algorithm with every geometry
+ *                          by default
+ *   --threads=T            numbers of threads, 1 and the hardware threads
+ *                          by default
+ *   --repeat=K             runs of each combination, 3 by default
+ *   --box=B                scale of the sites, as the box of
+ *                          lorawan-example; 100000 by default
+ *   --seed=S               seed of the sites, 1 by default
+ *   --output=FILE          where the JSON goes, standard output by default
+ *
+ * The sites are as follows, all within a few boxes of the origin:
+ *   uniform                uniform over a square of side 4 boxes
+ *   normal                 normal with a deviation of a box in x and y, as
+ *                          the sites of lorawan-example
+ *   clustered              normal around 100 centers, themselves normal
+ *                          as above, with a deviation of a box / 50
+ *   line                   uniform along 8 random segments 4 boxes long,
+ *                          a box / 1000 off them, as along roads
+ *
+ * The peak resident set of a run is measured by resetting the peak before
+ * the run where Linux allows it, through /proc/self/clear_refs, and is the
+ * peak of the whole process so far otherwise.  speedup is the time of the
+ * first number of threads listed over the time of the run.  Each run
+ * also gives the UdcCoverStats of its quickest repeat: the time of the
+ * sort, the cover and the assignment, the counters of the algorithm and
+ * its estimated working set, all 0 when built with UDC_STATS set to 0.
+ */
+
+#include "udc-cgal-geometry.h"
+#include "udc-cover-core.h"
+#include "udc-cover-stats.h"
+#include "udc-geometry.h"
+#include "udc-site-store.h"
+#include "udc-thread-pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+using namespace ns3;
+
+/*
+ * An algorithm, sweep engine and geometry to run.
+ */
+struct Variant
+{
+  std::string name;
+  UdcCover::Algorithm algorithm;
+  UdcCover::SweepEngine engine;
+  std::string geometry;
+};
+
+/*
+ * One timed run, as reported.
+ */
+struct Run
+{
+  std::string distribution;
+  size_t sites;
+  double radius;
+  const Variant *variant;
+  unsigned threads;
+  size_t disks;
+  double seconds;
+  double peakRss;
+  double speedup;
+  UdcCoverStats stats; //!< of the quickest repeat
+};
+
+static std::vector<std::string>
+Split (const std::string &list)
+{
+  std::vector<std::string> items;
+  size_t begin = 0;
+  while (begin <= list.size ())
+    {
+      size_t end = list.find (',', begin);
+      if (end == std::string::npos)
+        {
+          end = list.size ();
+        }
+      if (end > begin)
+        {
+          items.push_back (list.substr (begin, end - begin));
+        }
+      begin = end + 1;
+    }
+  return items;
+}
+
+static bool
+FindVariant (const std::string &name, Variant &variant)
+{
+  static const struct
+  {
+    const char *name;
+    UdcCover::Algorithm algorithm;
+    UdcCover::SweepEngine engine;
+  } algorithms[] = {{"fast", UdcCover::FAST_COVER, UdcCover::SWEEP_TREE},
+                    {"sweep", UdcCover::SWEEP, UdcCover::SWEEP_TREE},
+                    {"sweep-buckets", UdcCover::SWEEP, UdcCover::SWEEP_BUCKETS},
+                    {"strips", UdcCover::STRIPS, UdcCover::SWEEP_TREE},
+                    {"hex", UdcCover::FAST_COVER_HEX, UdcCover::SWEEP_TREE}};
+  const size_t colon = name.find (':');
+  const std::string algorithm = name.substr (0, colon);
+  const std::string geometry = colon == std::string::npos ? "double" : name.substr (colon + 1);
+  if (geometry != "double" && geometry != "float" && geometry != "cgal")
+    {
+      return false;
+    }
+  for (const auto &a : algorithms)
+    {
+      if (algorithm == a.name)
+        {
+          variant.name = algorithm + ":" + geometry;
+          variant.algorithm = a.algorithm;
+          variant.engine = a.engine;
+          variant.geometry = geometry;
+          return true;
+        }
+    }
+  return false;
+}
+
+/*
+ * Generate n sites of a distribution in parallel chunks, each seeded on
+ * its own, so that the sites do not depend on the threads.
+ */
+static bool
+Generate (const std::string &distribution, size_t n, double box, uint64_t seed, UdcThreadPool &pool,
+          std::vector<double> &x, std::vector<double> &y)
+{
+  // The centers of the clusters, or the ends of the segments
+  std::mt19937_64 shared (seed);
+  std::normal_distribution<double> normal (0, box);
+  std::uniform_real_distribution<double> uniform (-2 * box, 2 * box);
+  std::vector<double> ax, ay, bx, by;
+  if (distribution == "clustered")
+    {
+      for (int c = 0; c < 100; ++c)
+        {
+          ax.push_back (normal (shared));
+          ay.push_back (normal (shared));
+        }
+    }
+  else if (distribution == "line")
+    {
+      for (int l = 0; l < 8; ++l)
+        {
+          const double cx = uniform (shared) / 2, cy = uniform (shared) / 2;
+          const double angle = std::uniform_real_distribution<double> (0, M_PI) (shared);
+          ax.push_back (cx - 2 * box * std::cos (angle));
+          ay.push_back (cy - 2 * box * std::sin (angle));
+          bx.push_back (cx + 2 * box * std::cos (angle));
+          by.push_back (cy + 2 * box * std::sin (angle));
+        }
+    }
+  else if (distribution != "uniform" && distribution != "normal")
+    {
+      return false;
+    }
+
+  x.resize (n);
+  y.resize (n);
+  const size_t CHUNK = 1 << 20;
+  pool.ParallelFor ((n + CHUNK - 1) / CHUNK, [&] (size_t c, unsigned) {
+    std::mt19937_64 random (seed ^ ((c + 1) * 0x9e3779b97f4a7c15ULL));
+    std::normal_distribution<double> around (0, distribution == "line" ? box / 1000 : box / 50);
+    std::uniform_real_distribution<double> unit (0, 1);
+    std::normal_distribution<double> spread (0, box);
+    std::uniform_real_distribution<double> square (-2 * box, 2 * box);
+    for (size_t i = c * CHUNK; i < std::min (n, (c + 1) * CHUNK); ++i)
+      {
+        if (distribution == "uniform")
+          {
+            x[i] = square (random);
+            y[i] = square (random);
+          }
+        else if (distribution == "normal")
+          {
+            x[i] = spread (random);
+            y[i] = spread (random);
+          }
+        else if (distribution == "clustered")
+          {
+            const size_t k = random () % ax.size ();
+            x[i] = ax[k] + around (random);
+            y[i] = ay[k] + around (random);
+          }
+        else
+          {
+            const size_t k = random () % ax.size ();
+            const double t = unit (random);
+            x[i] = ax[k] + t * (bx[k] - ax[k]) + around (random);
+            y[i] = ay[k] + t * (by[k] - ay[k]) + around (random);
+          }
+      }
+  });
+  return true;
+}
+
+/*
+ * Reset the peak resident set to the current one, if the kernel allows.
+ */
+static bool
+ResetPeakRss (void)
+{
+  std::ofstream clear ("/proc/self/clear_refs");
+  clear << "5";
+  clear.flush ();
+  return bool (clear);
+}
+
+/*
+ * \return the peak resident set in bytes
+ */
+static double
+GetPeakRss (void)
+{
+  std::ifstream status ("/proc/self/status");
+  std::string line;
+  while (std::getline (status, line))
+    {
+      if (line.compare (0, 6, "VmHWM:") == 0)
+        {
+          return std::strtod (line.c_str () + 6, nullptr) * 1024;
+        }
+    }
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return double (usage.ru_maxrss) * 1024;
+}
+
+static size_t
+Cover (const UdcSiteStore &sites, double minX, double minY, double maxX, double maxY, double radius,
+       const Variant &variant, UdcThreadPool &pool, UdcCoverStats &stats)
+{
+  UdcCover cover (sites, minX, minY, maxX, maxY, pool);
+  cover.SetSweepEngine (variant.engine);
+  cover.SetStats (&stats);
+  std::vector<double> x, y;
+  if (variant.geometry == "float")
+    {
+      cover.Run<UdcFloatGeometry> (variant.algorithm, radius, x, y);
+    }
+  else if (variant.geometry == "cgal")
+    {
+      cover.Run<UdcCgalGeometry> (variant.algorithm, radius, x, y);
+    }
+  else
+    {
+      cover.Run<UdcDoubleGeometry> (variant.algorithm, radius, x, y);
+    }
+  return x.size ();
+}
+
+static void
+WriteJson (std::FILE *out, const std::vector<Run> &runs, double box, uint64_t seed, unsigned repeat)
+{
+  std::fprintf (out, "{\n  \"benchmark\": \"udc-bench\",\n  \"format\": 2,\n");
+  std::fprintf (out, "  \"hardware_threads\": %u,\n  \"box\": %.17g,\n  \"seed\": %llu,\n  \"repeat\": %u,\n",
+                std::thread::hardware_concurrency (), box, (unsigned long long) seed, repeat);
+  std::fprintf (out, "  \"runs\": [");
+  for (size_t r = 0; r < runs.size (); ++r)
+    {
+      const Run &run = runs[r];
+      std::fprintf (out, "%s\n    {\"distribution\": \"%s\", \"sites\": %zu, \"radius\": %.17g, "
+                    "\"variant\": \"%s\", \"threads\": %u, \"disks\": %zu, \"seconds\": %.9g, "
+                    "\"sites_per_second\": %.9g, \"ns_per_site\": %.9g, \"peak_rss_bytes\": %.0f, "
+                    "\"speedup\": %.6g, ",
+                    r == 0 ? "" : ",", run.distribution.c_str (), run.sites, run.radius,
+                    run.variant->name.c_str (), run.threads, run.disks, run.seconds,
+                    run.sites / run.seconds, run.seconds * 1e9 / run.sites, run.peakRss, run.speedup);
+      const UdcCoverStats &stats = run.stats;
+      std::fprintf (out, "\"phase_seconds\": {\"sort\": %.9g, \"cover\": %.9g, \"assign\": %.9g}, ",
+                    stats.seconds[UdcCoverStats::SORT], stats.seconds[UdcCoverStats::COVER],
+                    stats.seconds[UdcCoverStats::ASSIGN]);
+      std::fprintf (out, "\"cell_probes\": %llu, \"cell_inserts\": %llu, \"coverage_tests\": %llu, "
+                    "\"active_inserts\": %llu, \"active_erases\": %llu, \"deferred\": %llu, \"strips\": [",
+                    (unsigned long long) stats.cellProbes, (unsigned long long) stats.cellInserts,
+                    (unsigned long long) stats.coverageTests, (unsigned long long) stats.activeInserts,
+                    (unsigned long long) stats.activeErases, (unsigned long long) stats.deferred);
+      for (int k = 0; k < 6; ++k)
+        {
+          std::fprintf (out, "%s%llu", k == 0 ? "" : ", ", (unsigned long long) stats.strips[k]);
+        }
+      std::fprintf (out, "], \"working_set_bytes\": %llu}", (unsigned long long) stats.peakBytes);
+    }
+  std::fprintf (out, "\n  ]\n}\n");
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::vector<std::string> distributions = {"uniform", "normal", "clustered", "line"};
+  std::vector<size_t> counts = {1000, 10000, 100000, 1000000};
+  std::vector<double> radii = {1000, 10000};
+  std::vector<Variant> variants;
+  const unsigned hardware = std::max (1u, std::thread::hardware_concurrency ());
+  std::vector<unsigned> threads = {1};
+  if (hardware > 1)
+    {
+      threads.push_back (hardware);
+    }
+  unsigned repeat = 3;
+  double box = 100000;
+  uint64_t seed = 1;
+  std::string output;
+
+  for (const char *algorithm : {"fast", "sweep", "sweep-buckets", "strips", "hex"})
+    {
+      for (const char *geometry : {"double", "float", "cgal"})
+        {
+          variants.emplace_back ();
+          FindVariant (std::string (algorithm) + ":" + geometry, variants.back ());
+        }
+    }
+
+  for (int i = 1; i < argc; ++i)
+    {
+      const std::string arg = argv[i];
+      const size_t equals = arg.find ('=');
+      const std::string name = arg.substr (0, equals);
+      const std::vector<std::string> values = Split (equals == std::string::npos ? "" : arg.substr (equals + 1));
+      bool ok = !values.empty ();
+      if (ok && name == "--distributions")
+        {
+          distributions = values;
+        }
+      else if (ok && name == "--sites")
+        {
+          counts.clear ();
+          for (const std::string &v : values)
+            {
+              counts.push_back (size_t (std::strtod (v.c_str (), nullptr)));
+              ok = ok && counts.back () > 0 && counts.back () <= UINT32_MAX;
+            }
+        }
+      else if (ok && name == "--radii")
+        {
+          radii.clear ();
+          for (const std::string &v : values)
+            {
+              radii.push_back (std::strtod (v.c_str (), nullptr));
+              ok = ok && radii.back () > 0;
+            }
+        }
+      else if (ok && name == "--variants")
+        {
+          variants.assign (values.size (), Variant ());
+          for (size_t v = 0; v < values.size (); ++v)
+            {
+              ok = ok && FindVariant (values[v], variants[v]);
+            }
+        }
+      else if (ok && name == "--threads")
+        {
+          threads.clear ();
+          for (const std::string &v : values)
+            {
+              threads.push_back (std::strtoul (v.c_str (), nullptr, 10));
+              ok = ok && threads.back () > 0;
+            }
+        }
+      else if (ok && name == "--repeat")
+        {
+          repeat = std::strtoul (values[0].c_str (), nullptr, 10);
+          ok = repeat > 0;
+        }
+      else if (ok && name == "--box")
+        {
+          box = std::strtod (values[0].c_str (), nullptr);
+          ok = box > 0;
+        }
+      else if (ok && name == "--seed")
+        {
+          seed = std::strtoull (values[0].c_str (), nullptr, 10);
+        }
+      else if (ok && name == "--output")
+        {
+          output = values[0];
+        }
+      else
+        {
+          ok = false;
+        }
+      if (!ok)
+        {
+          std::fprintf (stderr, "udc-bench: bad argument %s\n", arg.c_str ());
+          return 1;
+        }
+    }
+
+  const bool resettable = ResetPeakRss ();
+  UdcThreadPool generator (hardware);
+  std::vector<Run> runs;
+  for (const std::string &distribution : distributions)
+    {
+      for (size_t n : counts)
+        {
+          std::vector<double> x, y;
+          if (!Generate (distribution, n, box, seed, generator, x, y))
+            {
+              std::fprintf (stderr, "udc-bench: unknown distribution %s\n", distribution.c_str ());
+              return 1;
+            }
+          const double minX = *std::min_element (x.begin (), x.end ()),
+                       maxX = *std::max_element (x.begin (), x.end ()),
+                       minY = *std::min_element (y.begin (), y.end ()),
+                       maxY = *std::max_element (y.begin (), y.end ());
+          UdcSiteStore sites;
+          sites.Assign (std::move (x), std::move (y));
+
+          for (double radius : radii)
+            {
+              for (const Variant &variant : variants)
+                {
+                  double first = 0;
+                  for (unsigned t : threads)
+                    {
+                      UdcThreadPool pool (t);
+                      Run run {distribution, n, radius, &variant, t, 0, 0, 0, 1};
+                      for (unsigned k = 0; k < repeat; ++k)
+                        {
+                          if (resettable)
+                            {
+                              ResetPeakRss ();
+                            }
+                          UdcCoverStats stats;
+                          const auto start = std::chrono::steady_clock::now ();
+                          run.disks = Cover (sites, minX, minY, maxX, maxY, radius, variant, pool, stats);
+                          const double seconds =
+                              std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+                          if (k == 0 || seconds < run.seconds)
+                            {
+                              run.seconds = seconds;
+                              run.stats = stats;
+                            }
+                          run.peakRss = std::max (run.peakRss, GetPeakRss ());
+                        }
+                      if (first == 0)
+                        {
+                          first = run.seconds;
+                        }
+                      run.speedup = first / run.seconds;
+                      runs.push_back (run);
+                      std::fprintf (stderr, "%s %zu r=%g %s t=%u: %zu disks, %.3f s\n", distribution.c_str (),
+                                    n, radius, variant.name.c_str (), t, run.disks, run.seconds);
+                    }
+                }
+            }
+        }
+    }
+
+  std::FILE *out = output.empty () ? stdout : std::fopen (output.c_str (), "w");
+  if (!out)
+    {
+      std::fprintf (stderr, "udc-bench: cannot write %s\n", output.c_str ());
+      return 2;
+    }
+  WriteJson (out, runs, box, seed, repeat);
+  if (out != stdout && std::fclose (out) != 0)
+    {
+      std::fprintf (stderr, "udc-bench: cannot write %s\n", output.c_str ());
+      return 2;
+    }
+  return 0;
+}
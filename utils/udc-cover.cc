@@ -0,0 +1,319 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2021
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Matthew Graham <mattgrahamatc@gmail.com>
+ */
+
+/*
+ * udc-cover: cover the sites of a file with disks and write the disk
+ * centers, without ns-3.
+ *
+ *   udc-cover --radius=R [options] SITES GATEWAYS
+ *
+ * SITES is a binary site file (see UdcSiteStore::MapFile), which is
+ * mapped, or text with one site per line as "x,y", "x;y" or "x y";
+ * blank lines, lines starting with '#' and a header line are skipped.
+ * GATEWAYS is written as "x,y" lines, or as a binary site file with
+ * --binary.  Either may be "-" for the standard input or output, in
+ * text.
+ *
+ * Options:
+ *   --radius=R             the radius of the disks (required)
+ *   --algorithm=A          fast (default), sweep, strips or hex, or 0 to 3
+ *                          as UDCPositionAllocator numbers them
+ *   --sweep-engine=E       tree (default) or buckets, for sweep
+ *   --geometry=G           double (default) or float, the arithmetic of the
+ *                          distance tests, see udc-geometry.h
+ *   --threads=N            worker threads, 0 for one per hardware thread;
+ *                          1 by default
+ *   --binary               write GATEWAYS as a binary site file
+ *   --svg=FILE             also draw the sites and disks to FILE, see UdcLayout
+ *   --verbose              report the sites, disks and time on stderr
+ *
+ * Exits with 0 on success, 1 on bad arguments and 2 if a file cannot be
+ * read or written.
+ */
+
+#include "udc-cover-core.h"
+#include "udc-layout.h"
+#include "udc-site-store.h"
+#include "udc-thread-pool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+static void
+Usage (void)
+{
+  std::fprintf (stderr, "usage: udc-cover --radius=R [--algorithm=fast|sweep|strips|hex] "
+                        "[--sweep-engine=tree|buckets] [--geometry=double|float] [--threads=N] [--binary] "
+                        "[--svg=FILE] [--verbose] SITES GATEWAYS\n");
+}
+
+/*
+ * Read text sites from a stream, one per line.
+ */
+static bool
+ReadText (std::FILE *in, std::vector<double> &x, std::vector<double> &y)
+{
+  std::string text;
+  char buffer[1 << 16];
+  size_t got;
+  while ((got = std::fread (buffer, 1, sizeof buffer, in)) > 0)
+    {
+      text.append (buffer, got);
+    }
+  if (std::ferror (in))
+    {
+      return false;
+    }
+
+  bool first = true;
+  for (size_t begin = 0; begin < text.size ();)
+    {
+      size_t end = text.find ('\n', begin);
+      if (end == std::string::npos)
+        {
+          end = text.size ();
+        }
+      // End the line in place, so that strtod cannot run on into the next
+      if (end < text.size ())
+        {
+          text[end] = '\0';
+        }
+      const char *p = text.c_str () + begin;
+      begin = end + 1;
+
+      while (*p == ' ' || *p == '\t' || *p == '\r')
+        {
+          ++p;
+        }
+      if (*p == '\0' || *p == '#')
+        {
+          continue;
+        }
+      char *next;
+      const double sx = std::strtod (p, &next);
+      bool ok = next != p;
+      p = next;
+      while (ok && (*p == ' ' || *p == '\t' || *p == ',' || *p == ';'))
+        {
+          ++p;
+        }
+      const double sy = ok ? std::strtod (p, &next) : 0;
+      ok = ok && next != p;
+      if (!ok)
+        {
+          // Only the first line may be a header
+          if (!first)
+            {
+              return false;
+            }
+          first = false;
+          continue;
+        }
+      first = false;
+      x.push_back (sx);
+      y.push_back (sy);
+    }
+  return true;
+}
+
+static bool
+WriteText (std::FILE *out, const std::vector<double> &x, const std::vector<double> &y)
+{
+  char line[64];
+  for (size_t d = 0; d < x.size (); ++d)
+    {
+      const int length = std::snprintf (line, sizeof line, "%.17g,%.17g\n", x[d], y[d]);
+      if (std::fwrite (line, 1, length, out) != size_t (length))
+        {
+          return false;
+        }
+    }
+  return std::fflush (out) == 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  double radius = 0;
+  UdcCover::Algorithm algorithm = UdcCover::FAST_COVER;
+  UdcCover::SweepEngine engine = UdcCover::SWEEP_TREE;
+  bool single = false;
+  unsigned threads = 1;
+  bool binary = false, verbose = false;
+  std::string svg;
+  std::vector<std::string> files;
+
+  for (int i = 1; i < argc; ++i)
+    {
+      const std::string arg = argv[i];
+      const size_t equals = arg.find ('=');
+      const std::string name = arg.substr (0, equals);
+      const std::string value = equals == std::string::npos ? "" : arg.substr (equals + 1);
+      if (name == "--radius")
+        {
+          radius = std::strtod (value.c_str (), nullptr);
+        }
+      else if (name == "--algorithm")
+        {
+          const char *names[] = {"fast", "sweep", "strips", "hex"};
+          int a = 0;
+          while (a < 4 && value != names[a] && value != std::to_string (a))
+            {
+              ++a;
+            }
+          if (a == 4)
+            {
+              Usage ();
+              return 1;
+            }
+          algorithm = UdcCover::Algorithm (a);
+        }
+      else if (name == "--sweep-engine" && (value == "tree" || value == "buckets"))
+        {
+          engine = value == "tree" ? UdcCover::SWEEP_TREE : UdcCover::SWEEP_BUCKETS;
+        }
+      else if (name == "--geometry" && (value == "double" || value == "float"))
+        {
+          single = value == "float";
+        }
+      else if (name == "--threads")
+        {
+          threads = std::strtoul (value.c_str (), nullptr, 10);
+        }
+      else if (name == "--svg" && !value.empty ())
+        {
+          svg = value;
+        }
+      else if (arg == "--binary")
+        {
+          binary = true;
+        }
+      else if (arg == "--verbose")
+        {
+          verbose = true;
+        }
+      else if (arg == "-" || arg[0] != '-')
+        {
+          files.push_back (arg);
+        }
+      else
+        {
+          Usage ();
+          return 1;
+        }
+    }
+  if (!(radius > 0) || files.size () != 2 || (binary && files[1] == "-"))
+    {
+      Usage ();
+      return 1;
+    }
+
+  const auto start = std::chrono::steady_clock::now ();
+  UdcSiteStore sites;
+  if (files[0] == "-" || !sites.MapFile (files[0]))
+    {
+      std::FILE *in = files[0] == "-" ? stdin : std::fopen (files[0].c_str (), "r");
+      std::vector<double> x, y;
+      if (!in || !ReadText (in, x, y))
+        {
+          std::fprintf (stderr, "udc-cover: cannot read sites from %s\n", files[0].c_str ());
+          return 2;
+        }
+      if (in != stdin)
+        {
+          std::fclose (in);
+        }
+      sites.Assign (std::move (x), std::move (y));
+    }
+  if (sites.GetN () > UINT32_MAX)
+    {
+      std::fprintf (stderr, "udc-cover: too many sites in %s\n", files[0].c_str ());
+      return 2;
+    }
+
+  double minX = 0, minY = 0, maxX = 0, maxY = 0;
+  for (size_t i = 0; i < sites.GetN (); ++i)
+    {
+      minX = i == 0 ? sites.X (i) : std::min (minX, sites.X (i));
+      minY = i == 0 ? sites.Y (i) : std::min (minY, sites.Y (i));
+      maxX = i == 0 ? sites.X (i) : std::max (maxX, sites.X (i));
+      maxY = i == 0 ? sites.Y (i) : std::max (maxY, sites.Y (i));
+    }
+
+  UdcThreadPool pool (threads == 0 ? std::max (1u, std::thread::hardware_concurrency ()) : threads);
+  UdcCover cover (sites, minX, minY, maxX, maxY, pool);
+  cover.SetSweepEngine (engine);
+  std::vector<double> x, y;
+  if (single)
+    {
+      cover.Run<UdcFloatGeometry> (algorithm, radius, x, y);
+    }
+  else
+    {
+      cover.Run<UdcDoubleGeometry> (algorithm, radius, x, y);
+    }
+
+  bool written;
+  if (binary)
+    {
+      written = UdcSiteStore::WriteFile (files[1], x.data (), y.data (), x.size ());
+    }
+  else
+    {
+      std::FILE *out = files[1] == "-" ? stdout : std::fopen (files[1].c_str (), "w");
+      written = out && WriteText (out, x, y);
+      if (out && out != stdout)
+        {
+          written = std::fclose (out) == 0 && written;
+        }
+    }
+  if (!written)
+    {
+      std::fprintf (stderr, "udc-cover: cannot write gateways to %s\n", files[1].c_str ());
+      return 2;
+    }
+
+  if (!svg.empty ())
+    {
+      // The bounds of the disks, as drawn
+      UdcLayout layout (minX - radius, minY - radius, maxX + radius, maxY + radius, 100000);
+      layout.SetSites (sites, pool);
+      layout.SetDisks (x.data (), y.data (), x.size (), radius);
+      if (!layout.WriteSvg (svg))
+        {
+          std::fprintf (stderr, "udc-cover: cannot write the layout to %s\n", svg.c_str ());
+          return 2;
+        }
+    }
+
+  if (verbose)
+    {
+      std::fprintf (stderr, "%zu sites, %zu disks, %.3f s\n", sites.GetN (), x.size (),
+                    std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ());
+    }
+  return 0;
+}